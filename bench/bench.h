@@ -0,0 +1,111 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "gpiobackend.h"
+
+struct BenchResult {
+    std::string name;
+    double value;
+    std::string unit;
+};
+
+using BenchResults = std::vector<BenchResult>;
+
+constexpr std::chrono::milliseconds BENCH_DURATION{1000};
+
+/**
+ * @param p percentile in [0, 1], sorts the samples
+ */
+inline double percentile(std::vector<double> &samples, double p) {
+    if(samples.empty()) {
+        return 0.0;
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[static_cast<std::size_t>(p * (samples.size() - 1))];
+}
+
+/**
+ * Toggles the status leds through the bridge (single pin writes) and through
+ * multi pin masks for BENCH_DURATION.
+ */
+BenchResults benchGpioToggle(const std::string &backendName, GpioBackendPtr backend);
+
+/**
+ * Throughput and one way latency of the shared memory channel and, for
+ * comparison, of the same payload over a TCP connection on loopback.
+ */
+BenchResults benchLocalChannel();
+
+/**
+ * setHigh / setLow and getDebounced through one bridge on simulated pins,
+ * with 1, 2 and 4 threads hammering it at the same time, and getDebounced
+ * with a debounce window of 0.
+ */
+BenchResults benchBridge();
+
+/**
+ * Commands queued and dispatched through the message loop, the way a decoded
+ * message or a local command takes. Mixed lanes, so collapsing is included.
+ */
+BenchResults benchDispatch();
+
+/**
+ * Deviation of the status bar blink pattern edges from their nominal times,
+ * switched by the status bar thread and played by a PwmPlayer.
+ */
+BenchResults benchStatusBar();
+
+/**
+ * Time from a curtain stop command to the CURTAIN_ON output going low, and
+ * from a main light command to the end of the confirmed relay pulse.
+ */
+BenchResults benchCurtain();
+
+/**
+ * Time from the last heartbeat of a stalling loop until the watchdog reports
+ * the stall (bound: deadline + check interval).
+ */
+BenchResults benchWatchdog();
+
+/**
+ * Time from a sound trigger until its first frame is audible (null sink),
+ * and the deviation of sounds started at a given time.
+ */
+BenchResults benchSound();
+
+/**
+ * Cost of a bridge write with telemetry recording and the size of
+ * the compressed batches for a typical mix of samples.
+ */
+BenchResults benchTelemetry();
+
+/**
+ * Several clock synchronised nodes with their own epochs and drifts on a
+ * simulated network: the skew between the nodes starting the same synced
+ * effect, compared with acting on arrival.
+ */
+BenchResults benchClockSync();
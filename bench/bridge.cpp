@@ -0,0 +1,93 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "bench.h"
+#include "bridge.h"
+#include "simbackend.h"
+
+#include <atomic>
+#include <thread>
+
+namespace {
+    template<typename F>
+    double opsPerSecond(int threads, F op) {
+        std::atomic<bool> go{false};
+        std::atomic<bool> stop{false};
+        std::atomic<long> ops{0};
+        std::vector<std::thread> workers;
+
+        for(int t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                while(!go) {
+                    std::this_thread::yield();
+                }
+                long n = 0;
+                while(!stop) {
+                    op(t);
+                    ++n;
+                }
+                ops += n;
+            });
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        go = true;
+        std::this_thread::sleep_for(BENCH_DURATION);
+        stop = true;
+        for(auto &w: workers) {
+            w.join();
+        }
+        return ops / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+BenchResults benchBridge() {
+    BenchResults results;
+
+    auto clock = std::make_shared<SystemClock>();
+    auto backend = std::make_shared<SimulatedBackend>(clock);
+    Bridge bridge{backend, clock, nullptr};
+
+    for(int threads: {1, 2, 4}) {
+        auto suffix = ".threads" + std::to_string(threads);
+
+        auto writes = opsPerSecond(threads, [&bridge](int t) {
+            auto pin = t % 2 ? Bridge::STATUS_RED : Bridge::STATUS_GREEN;
+            bridge.setHigh(pin);
+            bridge.setLow(pin);
+        });
+        // the simulated pins record every transition, don't let that grow
+        backend->takeTransitions();
+        results.push_back({"bridge.write" + suffix, writes * 2, "op/s"});
+
+        auto reads = opsPerSecond(threads, [&bridge](int t) {
+            bridge.getDebounced(t % 2 ? Bridge::LIGHT_STATE : Bridge::PUSH_BUTTON_STATE);
+        });
+        results.push_back({"bridge.debounced" + suffix, reads, "op/s"});
+    }
+
+    // a clean input, calibrated down to a single read
+    bridge.setDebounceWindow(Bridge::LIGHT_STATE, Clock::Duration::zero());
+    auto single = opsPerSecond(1, [&bridge](int) {
+        bridge.getDebounced(Bridge::LIGHT_STATE);
+    });
+    results.push_back({"bridge.debounced.window0.threads1", single, "op/s"});
+    return results;
+}
@@ -0,0 +1,204 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "bench.h"
+#include "clocksync.h"
+
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+    constexpr int NODES = 4;
+    constexpr std::chrono::minutes RUN{20};
+    // the followers need a few pings before they count as synced
+    constexpr std::chrono::minutes WARMUP{1};
+    constexpr std::chrono::seconds EFFECT_EVERY{5};
+
+    /**
+     * Monotonic clock of one node: an epoch and a rate of its own. Only now()
+     * is used, the harness drives the pings itself.
+     */
+    class NodeClock final: public Clock {
+    public:
+        NodeClock(const std::int64_t &trueNs, std::int64_t epoch, double drift):
+        trueNs{trueNs}, epoch{epoch}, drift{drift} {
+        }
+
+        TimePoint now() override {
+            return TimePoint{std::chrono::nanoseconds{epoch + std::llround(trueNs * (1.0 + drift))}};
+        }
+
+        std::int64_t toTrue(TimePoint t) const {
+            return std::llround((t.time_since_epoch().count() - epoch) / (1.0 + drift));
+        }
+
+        void sleepFor(Duration) override {
+            throw std::logic_error{"not simulated"};
+        }
+
+        void sleepFor(Duration, Alarm&) override {
+            throw std::logic_error{"not simulated"};
+        }
+
+        void wake(Alarm&) override {
+        }
+
+        std::thread startThread(std::function<void()> fn) override {
+            return std::thread{std::move(fn)};
+        }
+
+    private:
+        const std::int64_t &trueNs;
+        std::int64_t epoch;
+        double drift;
+    };
+
+    struct Network {
+        const char *name;
+        // one way, through the server
+        std::chrono::microseconds base;
+        std::chrono::microseconds jitter;
+        double spikeRate;
+        std::chrono::milliseconds spike;
+    };
+
+    /**
+     * NODES nodes (node 0 the reference) with random epochs and drifts of up
+     * to 100 ppm on a discrete event network. Every EFFECT_EVERY a random node
+     * starts a synced effect; the skew is the spread of the true times at
+     * which the nodes start it.
+     */
+    BenchResults run(const Network &net) {
+        std::mt19937_64 rng{42};
+        std::uniform_int_distribution<std::int64_t> epochs{0, 1000000000000};
+        std::uniform_real_distribution<double> drifts{-100e-6, 100e-6};
+        std::exponential_distribution<double> jitter{1.0 / std::max<double>(net.jitter.count(), 1.0)};
+        std::bernoulli_distribution spikes{net.spikeRate};
+        std::uniform_int_distribution<int> origins{0, NODES - 1};
+
+        auto oneWay = [&]() -> std::int64_t {
+            auto us = net.base.count() + jitter(rng) + (spikes(rng) ? std::chrono::microseconds{net.spike}.count() : 0);
+            return static_cast<std::int64_t>(us * 1000);
+        };
+
+        std::int64_t trueNs = 0;
+        std::vector<std::shared_ptr<NodeClock>> clocks;
+        std::vector<ClockSyncPtr> nodes;
+        for(int i = 0; i < NODES; ++i) {
+            std::string stateFile = "/tmp/moba-environment-bench-sync" + std::to_string(i) + ".conf";
+            std::ofstream{stateFile, std::ios::trunc} <<
+                "[sync]\n" <<
+                "mode=" << (i ? "follower" : "reference") << "\n" <<
+                "node=" << i << "\n";
+            clocks.push_back(std::make_shared<NodeClock>(trueNs, epochs(rng), i ? drifts(rng) : 0.0));
+            nodes.push_back(std::make_shared<ClockSync>(std::make_shared<moba::Ini>(stateFile), clocks.back()));
+        }
+        auto interval = std::chrono::nanoseconds{std::chrono::milliseconds{2000}}.count();
+        auto lead = std::chrono::nanoseconds{nodes[0]->getLead()}.count();
+
+        // (true time, sequence) -> event
+        std::map<std::pair<std::int64_t, std::uint64_t>, std::function<void()>> events;
+        std::uint64_t seq = 0;
+        auto at = [&](std::int64_t t, std::function<void()> fn) {
+            events.emplace(std::make_pair(t, seq++), std::move(fn));
+        };
+
+        std::function<void(int)> ping = [&](int i) {
+            auto p = nodes[i]->makePing();
+            at(trueNs + oneWay(), [&, i, p] {
+                auto pong = nodes[0]->answer(p);
+                at(trueNs + oneWay(), [&, i, pong]{nodes[i]->onPong(pong);});
+            });
+            at(trueNs + interval, [&, i]{ping(i);});
+        };
+        for(int i = 1; i < NODES; ++i) {
+            at(interval * i / NODES, [&, i]{ping(i);});
+        }
+
+        std::vector<double> skews;
+        std::vector<double> arrivals;
+        int late = 0;
+        std::function<void()> effect = [&] {
+            auto origin = origins(rng);
+            if(nodes[origin]->isSynced()) {
+                auto start = nodes[origin]->referenceNow() + lead;
+                std::int64_t first = std::numeric_limits<std::int64_t>::max();
+                std::int64_t last = std::numeric_limits<std::int64_t>::min();
+                std::int64_t firstArrival = trueNs;
+                std::int64_t lastArrival = trueNs;
+                for(int i = 0; i < NODES; ++i) {
+                    // the others get the message one network hop later
+                    auto arrival = i == origin ? trueNs : trueNs + oneWay();
+                    auto t = clocks[i]->toTrue(nodes[i]->toLocal(start));
+                    if(arrival > t) {
+                        ++late;
+                    }
+                    first = std::min(first, t);
+                    last = std::max(last, t);
+                    firstArrival = std::min(firstArrival, arrival);
+                    lastArrival = std::max(lastArrival, arrival);
+                }
+                skews.push_back((last - first) / 1000.0);
+                arrivals.push_back((lastArrival - firstArrival) / 1000.0);
+            }
+            at(trueNs + std::chrono::nanoseconds{EFFECT_EVERY}.count(), effect);
+        };
+        at(std::chrono::nanoseconds{WARMUP}.count(), effect);
+
+        auto end = std::chrono::nanoseconds{RUN}.count();
+        while(!events.empty() && events.begin()->first.first < end) {
+            auto iter = events.begin();
+            trueNs = iter->first.first;
+            auto fn = std::move(iter->second);
+            events.erase(iter);
+            fn();
+        }
+
+        if(skews.empty()) {
+            throw std::runtime_error{"never synced"};
+        }
+        std::string prefix = std::string{"clocksync."} + net.name;
+        return {
+            {prefix + ".skew.p50", percentile(skews, 0.5), "us"},
+            {prefix + ".skew.p99", percentile(skews, 0.99), "us"},
+            {prefix + ".skew.max", skews.back(), "us"},
+            {prefix + ".on_arrival.p99", percentile(arrivals, 0.99), "us"},
+            {prefix + ".late", static_cast<double>(late), "effects"},
+        };
+    }
+}
+
+BenchResults benchClockSync() {
+    BenchResults results;
+    for(const auto &net: {
+        Network{"lan", std::chrono::microseconds{300}, std::chrono::microseconds{200}, 0.0, std::chrono::milliseconds{0}},
+        Network{"busy", std::chrono::microseconds{1000}, std::chrono::microseconds{3000}, 0.05, std::chrono::milliseconds{80}},
+    }) {
+        auto r = run(net);
+        results.insert(results.end(), r.begin(), r.end());
+    }
+    return results;
+}
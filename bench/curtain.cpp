@@ -0,0 +1,122 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "bench.h"
+#include "eclipsecontrol.h"
+#include "simbackend.h"
+#include "watchdog.h"
+
+#include <fstream>
+#include <thread>
+
+namespace {
+    constexpr int RUNS = 8;
+    constexpr auto WAIT_TIMEOUT = std::chrono::seconds{5};
+    // a typical impulse relay
+    constexpr std::chrono::milliseconds RELAY_RESPONSE{25};
+
+    bool waitForOutput(SimulatedBackend &backend, Bridge::PinOutputMapping pin, bool level) {
+        auto deadline = std::chrono::steady_clock::now() + WAIT_TIMEOUT;
+        while(static_cast<bool>(backend.getOutputs() & Bridge::mask(pin)) != level) {
+            if(std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds{100});
+        }
+        return true;
+    }
+}
+
+BenchResults benchCurtain() {
+    std::string stateFile = "/tmp/moba-environment-bench.conf";
+    std::ofstream{stateFile, std::ios::trunc};
+
+    auto clock = std::make_shared<SystemClock>();
+    auto backend = std::make_shared<SimulatedBackend>(clock);
+    auto bridge = std::make_shared<Bridge>(backend, clock, nullptr);
+    auto ini = std::make_shared<moba::Ini>(stateFile);
+    auto watchdog = std::make_shared<Watchdog>(bridge, ini, clock);
+
+    backend->setImpulseRelay(Bridge::MAIN_LIGHT, Bridge::LIGHT_STATE, RELAY_RESPONSE);
+
+    std::vector<double> stopLatencies;
+    std::vector<double> switchLatencies;
+    {
+        EclipseControl eclctr{bridge, ini, clock, watchdog, nullptr};
+
+        for(int i = 0; i < RUNS; ++i) {
+            // alternate direction, so the curtain never hits an end position
+            if(i % 2) {
+                eclctr.curtainRunningUp();
+            } else {
+                eclctr.curtainRunningDown();
+            }
+            if(!waitForOutput(*backend, Bridge::CURTAIN_ON, true)) {
+                throw std::runtime_error{"curtain did not start"};
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds{300 + 37 * i});
+
+            backend->takeTransitions();
+            auto stop = clock->now();
+            if(i % 2) {
+                eclctr.curtainRunningUp();
+            } else {
+                eclctr.curtainRunningDown();
+            }
+            if(!waitForOutput(*backend, Bridge::CURTAIN_ON, false)) {
+                throw std::runtime_error{"curtain did not stop"};
+            }
+            for(const auto &t: backend->takeTransitions()) {
+                if(t.pin == Bridge::CURTAIN_ON && !t.level) {
+                    stopLatencies.push_back(std::chrono::duration<double, std::milli>(t.time - stop).count());
+                }
+            }
+        }
+
+        // the pulse ends once LIGHT_STATE confirmed the switch
+        for(int i = 0; i < RUNS; ++i) {
+            backend->takeTransitions();
+            auto command = clock->now();
+            if(i % 2) {
+                eclctr.mainLightOff();
+            } else {
+                eclctr.mainLightOn();
+            }
+            if(!waitForOutput(*backend, Bridge::MAIN_LIGHT, true) || !waitForOutput(*backend, Bridge::MAIN_LIGHT, false)) {
+                throw std::runtime_error{"main light did not switch"};
+            }
+            for(const auto &t: backend->takeTransitions()) {
+                if(t.pin == Bridge::MAIN_LIGHT && !t.level) {
+                    switchLatencies.push_back(std::chrono::duration<double, std::milli>(t.time - command).count());
+                }
+            }
+        }
+        if(eclctr.getLightStats().failures) {
+            throw std::runtime_error{"main light switch not confirmed"};
+        }
+    }
+
+    return {
+        {"curtain.stop.p50", percentile(stopLatencies, 0.50), "ms"},
+        {"curtain.stop.max", percentile(stopLatencies, 1.00), "ms"},
+        {"light.switch.p50", percentile(switchLatencies, 0.50), "ms"},
+        {"light.switch.max", percentile(switchLatencies, 1.00), "ms"},
+    };
+}
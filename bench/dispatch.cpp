@@ -0,0 +1,88 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "bench.h"
+#include "heapguard.h"
+#include "msgloop.h"
+#include "simbackend.h"
+#include "watchdog.h"
+
+#include <fstream>
+
+namespace {
+    constexpr int BATCH = 64;
+}
+
+BenchResults benchDispatch() {
+    std::string stateFile = "/tmp/moba-environment-bench.conf";
+    std::ofstream{stateFile, std::ios::trunc};
+
+    auto clock = std::make_shared<SystemClock>();
+    auto backend = std::make_shared<SimulatedBackend>(clock);
+    auto bridge = std::make_shared<Bridge>(backend, clock, nullptr);
+    auto ini = std::make_shared<moba::Ini>(stateFile);
+    auto watchdog = std::make_shared<Watchdog>(bridge, ini, clock);
+    auto status = std::make_shared<StatusControl>(bridge, ini, nullptr, clock, watchdog, nullptr);
+    auto eclctr = std::make_shared<EclipseControl>(bridge, ini, clock, watchdog, nullptr);
+    MessageLoop loop{nullptr, status, eclctr, bridge, clock, watchdog, {}};
+
+    LocalCommand on{};
+    on.type = LocalCommand::Type::AMBIENCE;
+    on.mainLightOn = LocalCommand::Toggle::ON;
+
+    LocalCommand off = on;
+    off.mainLightOn = LocalCommand::Toggle::OFF;
+
+    using HardwareState = SystemHardwareStateChanged::HardwareState;
+
+    // the bench thread plays the receiving and the dispatch thread, all it allocates counts
+    HeapGuard::guardThread();
+    auto heapBefore = HeapGuard::getStats().guarded;
+    HeapGuard::seal(false);
+
+    // batches like a burst on the wire: one safety message, the rest cosmetic (mostly collapsed)
+    long messages = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto end = start + BENCH_DURATION;
+    auto now = start;
+
+    while(now < end) {
+        loop.enqueueHardwareState(HardwareState::MANUEL);
+        for(int i = 1; i < BATCH; ++i) {
+            loop.enqueueLocal(i % 2 ? on : off);
+        }
+        loop.dispatchPending();
+        messages += BATCH;
+        now = std::chrono::steady_clock::now();
+    }
+    auto rate = messages / std::chrono::duration<double>(now - start).count();
+
+    HeapGuard::unseal();
+    auto heap = static_cast<double>(HeapGuard::getStats().guarded - heapBefore) / messages;
+
+    BenchResults results{
+        {"dispatch.throughput", rate, "msg/s"},
+    };
+    // only counted with the build option HEAP_GUARD
+    if(HeapGuard::ENABLED) {
+        results.push_back({"dispatch.heap", heap, "allocs/msg"});
+    }
+    return results;
+}
@@ -0,0 +1,75 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "bench.h"
+#include "bridge.h"
+
+namespace {
+    template<typename F>
+    double togglesPerSecond(F toggle) {
+        using Clock = std::chrono::steady_clock;
+
+        long toggles = 0;
+        auto start = Clock::now();
+        auto end = start + BENCH_DURATION;
+        auto now = start;
+
+        while(now < end) {
+            // check the clock only every 1024 toggles, it is slower than a write
+            for(int i = 0; i < 512; ++i) {
+                toggle(true);
+                toggle(false);
+            }
+            toggles += 1024;
+            now = Clock::now();
+        }
+        return toggles / std::chrono::duration<double>(now - start).count();
+    }
+}
+
+BenchResults benchGpioToggle(const std::string &backendName, GpioBackendPtr backend) {
+    Bridge bridge{backend, std::make_shared<SystemClock>(), nullptr};
+
+    auto single = togglesPerSecond([&bridge](bool high) {
+        if(high) {
+            bridge.setHigh(Bridge::STATUS_GREEN);
+        } else {
+            bridge.setLow(Bridge::STATUS_GREEN);
+        }
+    });
+
+    constexpr auto red = Bridge::mask(Bridge::STATUS_RED);
+    constexpr auto green = Bridge::mask(Bridge::STATUS_GREEN);
+
+    auto masked = togglesPerSecond([&bridge](bool high) {
+        if(high) {
+            bridge.setMask(red, green);
+        } else {
+            bridge.setMask(green, red);
+        }
+    });
+
+    bridge.setMask(0, red | green);
+
+    return {
+        {"gpio.toggle." + backendName + ".single", single, "toggles/s"},
+        {"gpio.toggle." + backendName + ".mask", masked, "toggles/s"},
+    };
+}
@@ -0,0 +1,181 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "bench.h"
+#include "localchannel.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+    constexpr int THROUGHPUT_MESSAGES = 1000000;
+    constexpr int LATENCY_MESSAGES = 10000;
+
+    /**
+     * Transport under test: send() from the producer thread, receive() from
+     * the consumer thread.
+     */
+    struct ShmTransport {
+        LocalChannel owner{"/moba-environment-bench", LocalChannel::Mode::OWNER};
+        LocalChannel client{"/moba-environment-bench", LocalChannel::Mode::CLIENT};
+
+        void send(const LocalCommand &cmd) {
+            while(!client.send(cmd)) {
+                std::this_thread::yield();
+            }
+        }
+
+        void receive(LocalCommand &cmd) {
+            while(!owner.receive(cmd, std::chrono::milliseconds{100})) {
+            }
+        }
+    };
+
+    struct TcpTransport {
+        int tx;
+        int rx;
+
+        TcpTransport() {
+            int listener = socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            socklen_t len = sizeof(addr);
+
+            if(
+                listener == -1 ||
+                bind(listener, reinterpret_cast<sockaddr*>(&addr), len) == -1 ||
+                listen(listener, 1) == -1 ||
+                getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &len) == -1
+            ) {
+                throw std::runtime_error{std::string{"unable to listen on loopback: "} + std::strerror(errno)};
+            }
+
+            tx = socket(AF_INET, SOCK_STREAM, 0);
+            if(tx == -1 || connect(tx, reinterpret_cast<sockaddr*>(&addr), len) == -1) {
+                throw std::runtime_error{std::string{"unable to connect on loopback: "} + std::strerror(errno)};
+            }
+            rx = accept(listener, nullptr, nullptr);
+            close(listener);
+
+            // same setting as for a message endpoint
+            int one = 1;
+            setsockopt(tx, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+
+        ~TcpTransport() {
+            close(tx);
+            close(rx);
+        }
+
+        void send(LocalCommand cmd) {
+            cmd.sentAt = LocalChannel::now();
+            transfer(tx, reinterpret_cast<char*>(&cmd), [](int fd, char *p, std::size_t n) {return ::send(fd, p, n, 0);});
+        }
+
+        void receive(LocalCommand &cmd) {
+            transfer(rx, reinterpret_cast<char*>(&cmd), [](int fd, char *p, std::size_t n) {return ::recv(fd, p, n, 0);});
+        }
+
+        template<typename F>
+        static void transfer(int fd, char *p, F io) {
+            std::size_t done = 0;
+            while(done < sizeof(LocalCommand)) {
+                auto n = io(fd, p + done, sizeof(LocalCommand) - done);
+                if(n <= 0) {
+                    throw std::runtime_error{"loopback connection broken"};
+                }
+                done += n;
+            }
+        }
+    };
+
+    template<typename T>
+    BenchResults run(const std::string &name, T &transport) {
+        LocalCommand cmd{};
+        cmd.type = LocalCommand::Type::AMBIENCE;
+        cmd.mainLightOn = LocalCommand::Toggle::ON;
+
+        // throughput: producer floods, consumer drains
+        auto start = std::chrono::steady_clock::now();
+        std::thread consumer{[&transport] {
+            LocalCommand in;
+            for(int i = 0; i < THROUGHPUT_MESSAGES; ++i) {
+                transport.receive(in);
+            }
+        }};
+        for(int i = 0; i < THROUGHPUT_MESSAGES; ++i) {
+            transport.send(cmd);
+        }
+        consumer.join();
+        auto throughput = THROUGHPUT_MESSAGES / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // latency: one message in flight, so the consumer is idle (sleeping) on every send
+        std::vector<double> latencies;
+        latencies.reserve(LATENCY_MESSAGES);
+        std::atomic<int> received{0};
+
+        consumer = std::thread{[&transport, &latencies, &received] {
+            LocalCommand in;
+            for(int i = 0; i < LATENCY_MESSAGES; ++i) {
+                transport.receive(in);
+                latencies.push_back((LocalChannel::now() - in.sentAt) / 1000.0);
+                received.store(i + 1, std::memory_order_release);
+            }
+        }};
+        for(int i = 0; i < LATENCY_MESSAGES; ++i) {
+            std::this_thread::sleep_for(std::chrono::microseconds{50});
+            transport.send(cmd);
+            while(received.load(std::memory_order_acquire) <= i) {
+                std::this_thread::yield();
+            }
+        }
+        consumer.join();
+
+        return {
+            {"ipc." + name + ".throughput", throughput, "msg/s"},
+            {"ipc." + name + ".latency.p50", percentile(latencies, 0.50), "us"},
+            {"ipc." + name + ".latency.p99", percentile(latencies, 0.99), "us"},
+        };
+    }
+}
+
+BenchResults benchLocalChannel() {
+    BenchResults results;
+
+    ShmTransport shm;
+    auto r = run("shm", shm);
+    results.insert(results.end(), r.begin(), r.end());
+
+    TcpTransport tcp;
+    r = run("tcp", tcp);
+    results.insert(results.end(), r.begin(), r.end());
+
+    return results;
+}
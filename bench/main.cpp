@@ -0,0 +1,164 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include <config.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <syslog.h>
+
+#include "bench.h"
+#include "gpiomembackend.h"
+#include "wiringpibackend.h"
+
+/*
+ * Runs the benchmarks on simulated pins (or a fake register block) and prints
+ * the results. With --json the results are also written machine readable:
+ *
+ *   {"package": "...", "version": "...", "timestamp": ..., "results": [
+ *       {"name": "...", "value": ..., "unit": "..."}, ...
+ *   ]}
+ *
+ *   moba-environment-bench [--only=<name>[,<name>...]] [--json=<file>] [--wiringpi] [--device=<file>]
+ */
+
+namespace {
+    [[noreturn]] void usage(const char *name) {
+        std::fprintf(
+            stderr,
+            "usage: %s [--only=<name>[,<name>...]] [--json=<file>] [--wiringpi] [--device=<gpiomem or plain file>]\n"
+            "benchmarks: gpio, ipc, bridge, dispatch, statusbar, curtain, watchdog, sound, telemetry,\n"
+            "            clocksync\n",
+            name
+        );
+        std::exit(EXIT_FAILURE);
+    }
+
+    void print(const BenchResults &results) {
+        for(const auto &r: results) {
+            std::printf("%-40s %14.1f %s\n", r.name.c_str(), r.value, r.unit.c_str());
+        }
+        std::fflush(stdout);
+    }
+
+    void writeJson(const std::string &fileName, const BenchResults &results) {
+        std::ofstream out{fileName};
+        if(!out) {
+            throw std::runtime_error{"unable to write <" + fileName + ">"};
+        }
+        out.precision(10);
+        out <<
+            "{\"package\": \"" << PACKAGE_NAME << "\", " <<
+            "\"version\": \"" << PACKAGE_VERSION << "\", " <<
+            "\"timestamp\": " << std::time(nullptr) << ", \"results\": [\n";
+
+        for(std::size_t i = 0; i < results.size(); ++i) {
+            const auto &r = results[i];
+            out <<
+                "    {\"name\": \"" << r.name << "\", \"value\": " << r.value <<
+                ", \"unit\": \"" << r.unit << "\"}" << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        out << "]}\n";
+    }
+}
+
+int main(const int argc, char *argv[]) {
+    // without a device a plain file serves as fake register block
+    std::string device = "/tmp/moba-environment-bench.gpio";
+    bool fakeDevice = true;
+    bool wiringPi = false;
+    std::string jsonFile;
+    std::set<std::string> only;
+
+    for(int i = 1; i < argc; ++i) {
+        std::string arg{argv[i]};
+        if(arg == "--wiringpi") {
+            wiringPi = true;
+        } else if(arg.starts_with("--device=")) {
+            device = arg.substr(9);
+            fakeDevice = false;
+        } else if(arg.starts_with("--json=")) {
+            jsonFile = arg.substr(7);
+        } else if(arg.starts_with("--only=")) {
+            std::istringstream names{arg.substr(7)};
+            for(std::string name; std::getline(names, name, ',');) {
+                only.insert(name);
+            }
+        } else {
+            usage(argv[0]);
+        }
+    }
+
+    if(fakeDevice) {
+        std::ofstream{device, std::ios::app};
+    }
+
+    // the handlers log every command, that is not what we want to measure
+    openlog("moba-environment-bench", 0, LOG_USER);
+    setlogmask(LOG_UPTO(LOG_WARNING));
+
+    const std::vector<std::pair<std::string, std::function<BenchResults()>>> benchmarks{
+        {"gpio", [&device, wiringPi] {
+            auto results = benchGpioToggle("gpiomem", std::make_shared<GpioMemBackend>(device));
+            // wiringPi needs real hardware
+            if(wiringPi) {
+                auto r = benchGpioToggle("wiringpi", std::make_shared<WiringPiBackend>(std::make_shared<SystemClock>()));
+                results.insert(results.end(), r.begin(), r.end());
+            }
+            return results;
+        }},
+        {"ipc",       benchLocalChannel},
+        {"bridge",    benchBridge},
+        {"dispatch",  benchDispatch},
+        {"statusbar", benchStatusBar},
+        {"curtain",   benchCurtain},
+        {"watchdog",  benchWatchdog},
+        {"sound",     benchSound},
+        {"telemetry", benchTelemetry},
+        {"clocksync", benchClockSync},
+    };
+
+    BenchResults all;
+    try {
+        for(const auto &[name, bench]: benchmarks) {
+            if(!only.empty() && !only.contains(name)) {
+                continue;
+            }
+            auto results = bench();
+            print(results);
+            all.insert(all.end(), results.begin(), results.end());
+        }
+        if(!jsonFile.empty()) {
+            writeJson(jsonFile, all);
+        }
+    } catch(const std::exception &e) {
+        std::fprintf(stderr, "benchmark failed: %s\n", e.what());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,119 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "bench.h"
+#include "soundengine.h"
+#include "soundsink.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+    constexpr unsigned int RATE = 44100;
+    constexpr int RUNS = 50;
+    constexpr std::chrono::milliseconds SCHEDULE_AHEAD{50};
+    constexpr auto WAIT_TIMEOUT = std::chrono::seconds{5};
+
+    // 100ms mono burst, as mono wave file
+    void writeClip(const std::string &path) {
+        std::vector<std::int16_t> samples(RATE / 10);
+        for(std::size_t i = 0; i < samples.size(); ++i) {
+            samples[i] = static_cast<std::int16_t>(8000 * std::sin(i * 0.05));
+        }
+        auto size = static_cast<std::uint32_t>(samples.size() * 2);
+
+        std::ofstream out{path, std::ios::binary | std::ios::trunc};
+        auto le32 = [&out](std::uint32_t v) {
+            char b[] = {char(v), char(v >> 8), char(v >> 16), char(v >> 24)};
+            out.write(b, 4);
+        };
+        auto le16 = [&out](std::uint16_t v) {
+            char b[] = {char(v), char(v >> 8)};
+            out.write(b, 2);
+        };
+        out.write("RIFF", 4);
+        le32(36 + size);
+        out.write("WAVEfmt ", 8);
+        le32(16);
+        le16(1);
+        le16(1);
+        le32(RATE);
+        le32(RATE * 2);
+        le16(2);
+        le16(16);
+        out.write("data", 4);
+        le32(size);
+        out.write(reinterpret_cast<const char*>(samples.data()), size);
+    }
+
+    Clock::Duration waitForStart(SoundEngine &engine, std::uint64_t starts) {
+        auto deadline = std::chrono::steady_clock::now() + WAIT_TIMEOUT;
+        while(true) {
+            auto stats = engine.getStats();
+            if(stats.starts > starts) {
+                return stats.lastLatency;
+            }
+            if(std::chrono::steady_clock::now() > deadline) {
+                throw std::runtime_error{"sound did not start"};
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds{200});
+        }
+    }
+}
+
+BenchResults benchSound() {
+    std::string clipFile = "/tmp/moba-environment-bench.wav";
+    std::string stateFile = "/tmp/moba-environment-bench.conf";
+    writeClip(clipFile);
+    std::ofstream{stateFile, std::ios::trunc};
+
+    auto ini = std::make_shared<moba::Ini>(stateFile);
+    ini->setString("sound", "thunder", clipFile);
+
+    auto clock = std::make_shared<SystemClock>();
+    SoundEngine engine{std::make_shared<NullSink>(RATE, clock), ini, clock};
+
+    std::vector<double> latencies;
+    std::vector<double> scheduleErrors;
+
+    for(int i = 0; i < RUNS; ++i) {
+        // random phase against the mixer period
+        std::this_thread::sleep_for(std::chrono::microseconds{1000 + std::rand() % 10000});
+
+        auto starts = engine.getStats().starts;
+        if(i % 2) {
+            engine.start(SoundEngine::Sound::THUNDER, clock->now() + SCHEDULE_AHEAD);
+            auto latency = waitForStart(engine, starts);
+            scheduleErrors.push_back(std::abs(std::chrono::duration<double, std::micro>(latency - SCHEDULE_AHEAD).count()));
+        } else {
+            engine.start(SoundEngine::Sound::THUNDER);
+            latencies.push_back(std::chrono::duration<double, std::milli>(waitForStart(engine, starts)).count());
+        }
+    }
+
+    return {
+        {"sound.trigger.p50",        percentile(latencies, 0.50),      "ms"},
+        {"sound.trigger.p99",        percentile(latencies, 0.99),      "ms"},
+        {"sound.scheduled.error.max", percentile(scheduleErrors, 1.00), "us"},
+    };
+}
@@ -0,0 +1,139 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "bench.h"
+#include "pwmplayer.h"
+#include "simbackend.h"
+#include "statuscontrol.h"
+#include "watchdog.h"
+
+#include <cmath>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+namespace {
+    constexpr std::chrono::seconds RUN_TIME{6};
+
+    // MANUEL: green on for 25 + 700ms, off for 750ms
+    constexpr std::chrono::milliseconds ON_TIME{725};
+    constexpr std::chrono::milliseconds OFF_TIME{750};
+
+    /**
+     * Edge deviations of the same blink played by a PwmPlayer, the way the
+     * wiringPi backend times it, and its duty cycle writes per second for a
+     * breathing led next to it.
+     */
+    BenchResults benchPwmPlayer() {
+        struct Write {
+            Clock::TimePoint time;
+            int pin;
+            std::uint16_t duty;
+        };
+        std::mutex m;
+        std::vector<Write> writes;
+        writes.reserve(4096);
+
+        auto clock = std::make_shared<SystemClock>();
+        std::uint64_t count;
+        {
+            PwmPlayer player{clock, [&](int pin, std::uint16_t duty) {
+                std::lock_guard<std::mutex> l{m};
+                writes.push_back({clock->now(), pin, duty});
+            }};
+            player.play(Bridge::STATUS_GREEN, PwmPattern::blink(ON_TIME, OFF_TIME));
+            player.play(Bridge::STATUS_RED, PwmPattern::breathe(std::chrono::seconds{3}, 0, PwmPattern::FULL));
+            std::this_thread::sleep_for(RUN_TIME);
+            count = player.writes();
+        }
+
+        std::vector<double> deviations;
+        const Write *last = nullptr;
+        std::uint64_t breathing = 0;
+        std::lock_guard<std::mutex> l{m};
+        for(const auto &w: writes) {
+            if(w.pin != Bridge::STATUS_GREEN) {
+                ++breathing;
+                continue;
+            }
+            if(last) {
+                auto nominal = last->duty ? ON_TIME : OFF_TIME;
+                auto actual = w.time - last->time;
+                deviations.push_back(std::abs(std::chrono::duration<double, std::micro>(actual - nominal).count()));
+            }
+            last = &w;
+        }
+        auto seconds = std::chrono::duration<double>(RUN_TIME).count();
+
+        return {
+            {"statusbar.pwm.jitter.p50", percentile(deviations, 0.50), "us"},
+            {"statusbar.pwm.jitter.p99", percentile(deviations, 0.99), "us"},
+            {"statusbar.pwm.breathe.writes", breathing / seconds, "writes/s"},
+            {"statusbar.pwm.writes", count / seconds, "writes/s"},
+        };
+    }
+}
+
+BenchResults benchStatusBar() {
+    std::string stateFile = "/tmp/moba-environment-bench.conf";
+    std::ofstream{stateFile, std::ios::trunc};
+
+    auto clock = std::make_shared<SystemClock>();
+    auto backend = std::make_shared<SimulatedBackend>(clock);
+    auto bridge = std::make_shared<Bridge>(backend, clock, nullptr);
+    auto ini = std::make_shared<moba::Ini>(stateFile);
+    auto watchdog = std::make_shared<Watchdog>(bridge, ini, clock);
+
+    std::vector<SimulatedBackend::Transition> transitions;
+    {
+        StatusControl status{bridge, ini, nullptr, clock, watchdog, nullptr};
+        status.setStatusBar(StatusControl::StatusBarState::MANUEL);
+        // let the pattern of the initial state run out
+        std::this_thread::sleep_for(std::chrono::milliseconds{100});
+        backend->takeTransitions();
+
+        std::this_thread::sleep_for(RUN_TIME);
+        transitions = backend->takeTransitions();
+    }
+
+    std::vector<double> deviations;
+    const SimulatedBackend::Transition *last = nullptr;
+
+    for(const auto &t: transitions) {
+        if(t.pin != Bridge::STATUS_GREEN) {
+            continue;
+        }
+        if(last) {
+            auto nominal = last->level ? ON_TIME : OFF_TIME;
+            auto actual = t.time - last->time;
+            deviations.push_back(std::abs(std::chrono::duration<double, std::micro>(actual - nominal).count()));
+        }
+        last = &t;
+    }
+
+    BenchResults results{
+        {"statusbar.jitter.p50", percentile(deviations, 0.50), "us"},
+        {"statusbar.jitter.p99", percentile(deviations, 0.99), "us"},
+        {"statusbar.jitter.max", percentile(deviations, 1.00), "us"},
+    };
+    auto pwm = benchPwmPlayer();
+    results.insert(results.end(), pwm.begin(), pwm.end());
+    return results;
+}
@@ -0,0 +1,89 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+#include "bench.h"
+#include "bridge.h"
+#include "simbackend.h"
+#include "telemetry.h"
+
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+    // well below the ring capacity, the telemetry thread drains every 100ms
+    constexpr int BURST = 1000;
+    constexpr int BURSTS = 10;
+    constexpr std::chrono::milliseconds PAUSE{150};
+}
+
+BenchResults benchTelemetry() {
+    std::string stateFile = "/tmp/moba-environment-bench.conf";
+    std::ofstream{stateFile, std::ios::trunc};
+
+    auto clock = std::make_shared<SystemClock>();
+    auto ini = std::make_shared<moba::Ini>(stateFile);
+    auto telemetry = std::make_shared<Telemetry>(nullptr, ini, clock);
+    auto backend = std::make_shared<SimulatedBackend>(clock);
+    auto bridge = std::make_shared<Bridge>(backend, clock, telemetry);
+    telemetry->start();
+
+    std::vector<double> costs;
+    int pos = 0;
+
+    // status bar blinking, curtain running, now and then a light switch
+    for(int i = 0; i < BURSTS; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        for(int j = 0; j < BURST; ++j) {
+            switch(j % 4) {
+                case 0:
+                    bridge->setMask(Bridge::mask(Bridge::STATUS_GREEN), Bridge::mask(Bridge::STATUS_RED));
+                    break;
+
+                case 1:
+                    bridge->setLow(Bridge::STATUS_GREEN);
+                    break;
+
+                case 2:
+                    telemetry->record(Telemetry::Kind::CURTAIN_POS, 0, pos = (pos + 1) % 121);
+                    break;
+
+                default:
+                    bridge->setHigh(j % 64 == 3 ? Bridge::MAIN_LIGHT : Bridge::CURTAIN_ON);
+                    bridge->setLow(Bridge::MAIN_LIGHT);
+                    break;
+            }
+        }
+        costs.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / BURST);
+        std::this_thread::sleep_for(PAUSE);
+    }
+    telemetry->stop();
+
+    auto stats = telemetry->getStats();
+    if(stats.dropped || !stats.batches) {
+        throw std::runtime_error{"samples dropped"};
+    }
+    return {
+        {"telemetry.write_recorded.p50",  percentile(costs, 0.50), "ns"},
+        {"telemetry.samples",             static_cast<double>(stats.samples), "samples"},
+        {"telemetry.batches",             static_cast<double>(stats.batches), "batches"},
+        {"telemetry.raw_per_sample",      static_cast<double>(stats.rawBytes) / stats.samples, "bytes"},
+        {"telemetry.compressed_per_sample", static_cast<double>(stats.compressedBytes) / stats.samples, "bytes"},
+    };
+}
@@ -0,0 +1,76 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "bench.h"
+#include "simbackend.h"
+#include "watchdog.h"
+
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+    constexpr int RUNS = 10;
+    constexpr std::chrono::milliseconds DEADLINE{200};
+    constexpr auto WAIT_TIMEOUT = std::chrono::seconds{5};
+}
+
+BenchResults benchWatchdog() {
+    std::string stateFile = "/tmp/moba-environment-bench.conf";
+    std::ofstream{stateFile, std::ios::trunc};
+
+    auto clock = std::make_shared<SystemClock>();
+    auto backend = std::make_shared<SimulatedBackend>(clock);
+    auto bridge = std::make_shared<Bridge>(backend, clock, nullptr);
+    Watchdog watchdog{bridge, std::make_shared<moba::Ini>(stateFile), clock};
+
+    std::vector<double> detectionTimes;
+
+    for(int i = 0; i < RUNS; ++i) {
+        auto heartbeat = watchdog.registerLoop("bench" + std::to_string(i), DEADLINE);
+        auto stalls = watchdog.getStats().stalls;
+
+        // beat for a while, then stall at a random phase of the check interval
+        for(int j = 0; j < 5 + i; ++j) {
+            heartbeat->beat();
+            std::this_thread::sleep_for(std::chrono::milliseconds{13});
+        }
+        heartbeat->beat();
+
+        auto deadline = std::chrono::steady_clock::now() + WAIT_TIMEOUT;
+        Watchdog::Stats stats;
+        while((stats = watchdog.getStats()).stalls == stalls) {
+            if(std::chrono::steady_clock::now() > deadline) {
+                throw std::runtime_error{"stall not detected"};
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        detectionTimes.push_back(std::chrono::duration<double, std::milli>(stats.lastDetectionTime).count());
+        if(!(backend->getOutputs() & Bridge::mask(Bridge::STATUS_RED))) {
+            throw std::runtime_error{"outputs not parked"};
+        }
+        heartbeat->pause();
+    }
+
+    return {
+        {"watchdog.detection.p50", percentile(detectionTimes, 0.50), "ms"},
+        {"watchdog.detection.max", percentile(detectionTimes, 1.00), "ms"},
+    };
+}
@@ -0,0 +1,190 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <string>
+#include <syslog.h>
+#include <vector>
+
+#include "simulation.h"
+
+/*
+ * Runs the daemon against a script in virtual time and prints every output
+ * transition as "<seconds> <pin> <level>". Two runs of the same script
+ * produce the same trace, so traces can be diffed in CI.
+ *
+ *   moba-environment-sim [--verbose] [--states] [--tail=<duration>] [--state=<file>] [--set=<section>.<key>=<value>...] <script>
+ *
+ * --states adds the transitions of the eclipse control state machines as
+ * "<seconds> <machine> <from> -<event>-> <to>" to the trace. --set puts a
+ * setting into the otherwise empty state file, e.g. --set=light.driver=dimmer.
+ * A pattern played on a PWM output shows up as "<seconds> <pin> pwm <pattern>".
+ */
+
+namespace {
+    [[noreturn]] void usage(const char *name) {
+        std::fprintf(
+            stderr, "usage: %s [--verbose] [--states] [--tail=<duration>] [--state=<file>] [--set=<section>.<key>=<value>...] <script>\n",
+            name
+        );
+        std::exit(EXIT_FAILURE);
+    }
+
+    const char *pinName(int pin) {
+        static const std::map<int, const char*> names{
+            {Bridge::STATUS_GREEN, "STATUS_GREEN"},
+            {Bridge::STATUS_RED,   "STATUS_RED"},
+            {Bridge::SHUTDOWN,     "SHUTDOWN"},
+            {Bridge::MAIN_LIGHT,   "MAIN_LIGHT"},
+            {Bridge::CURTAIN_DIR,  "CURTAIN_DIR"},
+            {Bridge::CURTAIN_ON,   "CURTAIN_ON"},
+        };
+        auto iter = names.find(pin);
+        return iter == names.end() ? "?" : iter->second;
+    }
+}
+
+int main(const int argc, char *argv[]) {
+    std::string script;
+    std::string stateFile = "/tmp/moba-environment-sim.conf";
+    std::chrono::milliseconds tail{60000};
+    bool verbose = false;
+    bool states = false;
+    // section -> key=value lines
+    std::map<std::string, std::string> settings;
+
+    try {
+        for(int i = 1; i < argc; ++i) {
+            std::string arg{argv[i]};
+            if(arg == "--verbose") {
+                verbose = true;
+            } else if(arg == "--states") {
+                states = true;
+            } else if(arg.starts_with("--tail=")) {
+                tail = parseDuration(arg.substr(7));
+            } else if(arg.starts_with("--state=")) {
+                stateFile = arg.substr(8);
+            } else if(arg.starts_with("--set=")) {
+                auto dot = arg.find('.');
+                auto eq = arg.find('=', 6);
+                if(dot == std::string::npos || dot > eq || eq == std::string::npos) {
+                    usage(argv[0]);
+                }
+                settings[arg.substr(6, dot - 6)] += arg.substr(dot + 1) + "\n";
+            } else if(script.empty() && !arg.starts_with("--")) {
+                script = arg;
+            } else {
+                usage(argv[0]);
+            }
+        }
+    } catch(const std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        usage(argv[0]);
+    }
+
+    if(script.empty()) {
+        usage(argv[0]);
+    }
+
+    openlog("moba-environment-sim", verbose ? LOG_PERROR : 0, LOG_USER);
+    if(!verbose) {
+        setlogmask(LOG_UPTO(LOG_WARNING));
+    }
+
+    // fresh state on every run, otherwise runs would depend on each other
+    {
+        std::ofstream state{stateFile, std::ios::trunc};
+        for(const auto &[section, lines]: settings) {
+            state << '[' << section << "]\n" << lines;
+        }
+    }
+
+    try {
+        auto events = loadScript(script);
+
+        auto wallStart = std::chrono::steady_clock::now();
+        std::chrono::milliseconds simulated;
+        Watchdog::Stats watchdogStats;
+        EclipseControl::LightStats lightStats;
+        std::vector<DebounceCalibration::Result> calibration;
+        {
+            Simulation sim{stateFile};
+            sim.setTransitionHandler([](std::chrono::milliseconds time, const SimulatedBackend::Transition &t) {
+                std::printf("%12.3f %-12s %d\n", time.count() / 1000.0, pinName(t.pin), t.level);
+            });
+            sim.setPwmHandler([](std::chrono::milliseconds time, const SimulatedBackend::PwmChange &c) {
+                std::printf("%12.3f %-12s pwm %s\n", time.count() / 1000.0, pinName(c.pin), c.pattern.describe().c_str());
+            });
+            if(states) {
+                sim.setStateHandler([](std::chrono::milliseconds time, const EclipseControl::TransitionRecord &r) {
+                    if(r.accepted) {
+                        std::printf("%12.3f %-12s %s -%s-> %s\n", time.count() / 1000.0, r.machine, r.from, r.event, r.to);
+                    } else {
+                        std::printf("%12.3f %-12s %s -%s-> rejected\n", time.count() / 1000.0, r.machine, r.from, r.event);
+                    }
+                });
+            }
+            sim.run(events, tail);
+            simulated = sim.elapsed();
+            watchdogStats = sim.watchdog->getStats();
+            lightStats = sim.eclctr->getLightStats();
+            calibration = sim.calibration->getResults();
+        }
+        auto wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+        std::fprintf(
+            stderr, "simulated %.1f s in %.3f s wall time (%.0fx)\n",
+            simulated.count() / 1000.0, wall, simulated.count() / 1000.0 / wall
+        );
+        if(watchdogStats.stalls) {
+            std::fprintf(
+                stderr, "watchdog: %u stall(s), max detection time %.1f ms\n", watchdogStats.stalls,
+                std::chrono::duration<double, std::milli>(watchdogStats.maxDetectionTime).count()
+            );
+        }
+        if(lightStats.switches || lightStats.failures) {
+            std::fprintf(
+                stderr, "light: %llu switch(es), %llu retries, %llu failure(s), response %.1f ms, pulse %.1f ms\n",
+                static_cast<unsigned long long>(lightStats.switches), static_cast<unsigned long long>(lightStats.retries),
+                static_cast<unsigned long long>(lightStats.failures),
+                std::chrono::duration<double, std::milli>(lightStats.response).count(),
+                std::chrono::duration<double, std::milli>(lightStats.pulse).count()
+            );
+        }
+        for(const auto &r: calibration) {
+            auto us = [](Clock::Duration d) {
+                return std::chrono::duration<double, std::micro>(d).count();
+            };
+            std::fprintf(
+                stderr, "debounce %-12s %zu edges, bounce p50 %.0f us, p99 %.0f us, max %.0f us -> window %.0f us%s\n",
+                r.pin == Bridge::LIGHT_STATE ? "LIGHT_STATE" : "PUSH_BUTTON", r.edges,
+                us(r.p50), us(r.p99), us(r.max), us(r.window), r.applied ? "" : " (unchanged)"
+            );
+        }
+    } catch(const std::exception &e) {
+        std::fprintf(stderr, "simulation failed: %s\n", e.what());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
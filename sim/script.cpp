@@ -0,0 +1,95 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "script.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+std::chrono::milliseconds parseDuration(const std::string &str) {
+    std::size_t pos = 0;
+    double val;
+    try {
+        val = std::stod(str, &pos);
+    } catch(const std::exception&) {
+        throw std::runtime_error{"invalid duration <" + str + ">"};
+    }
+
+    auto unit = str.substr(pos);
+    double factor;
+    if(unit == "ms") {
+        factor = 1;
+    } else if(unit == "s") {
+        factor = 1000;
+    } else if(unit == "m") {
+        factor = 60 * 1000;
+    } else if(unit == "h") {
+        factor = 60 * 60 * 1000;
+    } else {
+        throw std::runtime_error{"invalid duration unit <" + str + ">"};
+    }
+    return std::chrono::milliseconds{static_cast<long long>(val * factor)};
+}
+
+std::vector<ScriptEvent> loadScript(const std::string &fileName) {
+    std::ifstream in{fileName};
+    if(!in) {
+        throw std::runtime_error{"unable to open script <" + fileName + ">"};
+    }
+
+    std::vector<ScriptEvent> events;
+    std::chrono::milliseconds last{0};
+    std::string line;
+
+    for(int lineNo = 1; std::getline(in, line); ++lineNo) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream tokens{line};
+
+        std::string time;
+        if(!(tokens >> time)) {
+            continue;
+        }
+
+        ScriptEvent event{{}, lineNo, {}, {}};
+        try {
+            if(time.size() < 2 || (time[0] != '@' && time[0] != '+')) {
+                throw std::runtime_error{"time must start with '@' or '+'"};
+            }
+            auto d = parseDuration(time.substr(1));
+            event.time = time[0] == '@' ? d : last + d;
+            if(event.time < last) {
+                throw std::runtime_error{"time runs backwards"};
+            }
+            if(!(tokens >> event.command)) {
+                throw std::runtime_error{"command missing"};
+            }
+        } catch(const std::runtime_error &e) {
+            throw std::runtime_error{fileName + ":" + std::to_string(lineNo) + ": " + e.what()};
+        }
+
+        for(std::string arg; tokens >> arg;) {
+            event.args.push_back(arg);
+        }
+        last = event.time;
+        events.push_back(std::move(event));
+    }
+    return events;
+}
@@ -0,0 +1,68 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+/**
+ * Scripted message stream for the simulation. One event per line:
+ *
+ *   <time> <command> [args...]
+ *
+ * time is "@<duration>" (since start) or "+<duration>" (since the previous
+ * event), duration is a number with unit ms, s, m or h, e.g. "+2h", "@250ms".
+ * Everything after '#' is a comment.
+ *
+ * commands:
+ *   hardware ERROR|STANDBY|EMERGENCY_STOP|MANUEL|AUTOMATIC
+ *   ambience [curtain=on|off] [light=on|off]
+ *   curtain up|down
+ *   effect <name>
+ *   scene <name>             from section [scenes] of the state file
+ *   button <duration>        push button pressed for duration
+ *   light on|off             main light switched by hand
+ *   relay <duration> [<lag>]|stuck
+ *                            response time of the main light relay (30ms at
+ *                            start) and how long its feedback contact lags
+ *                            behind (none by default), a stuck relay never
+ *                            switches
+ *   bounce light|button <d>  contact bounce of the input from now on, <d> may
+ *                            be given in us as well, e.g. 800us
+ *   calibrate <duration>     debounce calibration, whole seconds
+ *   duty red|green|light <permille>|<min>..<max>
+ *                            fails unless the PWM output has that duty cycle
+ *                            right now (status.pwm=1, light.driver=dimmer)
+ */
+struct ScriptEvent {
+    std::chrono::milliseconds time;
+    int line;
+    std::string command;
+    std::vector<std::string> args;
+};
+
+/**
+ * @throws std::runtime_error on syntax errors, with file and line
+ */
+std::vector<ScriptEvent> loadScript(const std::string &fileName);
+
+std::chrono::milliseconds parseDuration(const std::string &str);
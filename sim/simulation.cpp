@@ -0,0 +1,287 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "simulation.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    using HardwareState = SystemHardwareStateChanged::HardwareState;
+
+    HardwareState toHardwareState(const std::string &name) {
+        static const std::map<std::string, HardwareState> states{
+            {"ERROR",          HardwareState::ERROR},
+            {"STANDBY",        HardwareState::STANDBY},
+            {"EMERGENCY_STOP", HardwareState::EMERGENCY_STOP},
+            {"MANUEL",         HardwareState::MANUEL},
+            {"AUTOMATIC",      HardwareState::AUTOMATIC},
+        };
+        auto iter = states.find(name);
+        if(iter == states.end()) {
+            throw std::runtime_error{"unknown hardware state <" + name + ">"};
+        }
+        return iter->second;
+    }
+
+    LocalCommand::Toggle toToggle(const std::string &val) {
+        if(val == "on") {
+            return LocalCommand::Toggle::ON;
+        }
+        if(val == "off") {
+            return LocalCommand::Toggle::OFF;
+        }
+        throw std::runtime_error{"expected on or off, got <" + val + ">"};
+    }
+
+    Bridge::PinOutputMapping toPwmOutput(const std::string &name) {
+        static const std::map<std::string, Bridge::PinOutputMapping> outputs{
+            {"red",   Bridge::STATUS_RED},
+            {"green", Bridge::STATUS_GREEN},
+            {"light", Bridge::MAIN_LIGHT},
+        };
+        auto iter = outputs.find(name);
+        if(iter == outputs.end()) {
+            throw std::runtime_error{"unknown pwm output <" + name + ">"};
+        }
+        return iter->second;
+    }
+}
+
+Simulation::Simulation(const std::string &stateFile) {
+    clock = std::make_shared<VirtualClock>();
+    start = clock->now();
+
+    backend = std::make_shared<SimulatedBackend>(clock);
+    backend->setImpulseRelay(Bridge::MAIN_LIGHT, Bridge::LIGHT_STATE, RELAY_RESPONSE);
+
+    auto ini = std::make_shared<moba::Ini>(stateFile);
+
+    bridge = std::make_shared<Bridge>(backend, clock, nullptr);
+    watchdog = std::make_shared<Watchdog>(bridge, ini, clock);
+    status = std::make_shared<StatusControl>(bridge, ini, nullptr, clock, watchdog, nullptr);
+    eclctr = std::make_shared<EclipseControl>(bridge, ini, clock, watchdog, nullptr);
+    auto scenes = std::make_shared<SceneTable>(ini);
+    calibration = std::make_shared<DebounceCalibration>(bridge, ini, clock);
+    loop = std::make_unique<MessageLoop>(
+        nullptr, status, eclctr, bridge, clock, watchdog, MessageLoop::Options{.scenes = scenes, .calibration = calibration}
+    );
+}
+
+Simulation::~Simulation() noexcept {
+    clock->release();
+    loop.reset();
+    calibration.reset();
+    eclctr.reset();
+    status.reset();
+    watchdog.reset();
+}
+
+void Simulation::setTransitionHandler(TransitionHandler handler) {
+    transitionHandler = handler;
+}
+
+void Simulation::setPwmHandler(PwmHandler handler) {
+    pwmHandler = handler;
+}
+
+void Simulation::setStateHandler(StateHandler handler) {
+    // runs in the loop thread while the driver waits in advanceTo(), so flushing here keeps the order
+    eclctr->setTransitionObserver([this, handler](const EclipseControl::TransitionRecord &rec) {
+        flushTransitions();
+        handler(std::chrono::duration_cast<std::chrono::milliseconds>(rec.time - start), rec);
+    });
+}
+
+void Simulation::run(const std::vector<ScriptEvent> &events, std::chrono::milliseconds tail) {
+    for(const auto &event: events) {
+        schedule(event.time, [this, &event] {
+            try {
+                apply(event);
+            } catch(const std::runtime_error &e) {
+                throw std::runtime_error{"line " + std::to_string(event.line) + ": " + e.what()};
+            }
+        });
+    }
+
+    while(!pending.empty()) {
+        auto iter = pending.begin();
+        auto time = iter->first.first;
+        auto action = std::move(iter->second);
+        pending.erase(iter);
+
+        advanceTo(time);
+        action();
+        loop->dispatchPending();
+        flushTransitions();
+    }
+    advanceTo(elapsed() + tail);
+}
+
+std::chrono::milliseconds Simulation::elapsed() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(clock->now() - start);
+}
+
+void Simulation::schedule(std::chrono::milliseconds time, Action action) {
+    pending.emplace(std::make_pair(time, nextSeq++), std::move(action));
+}
+
+void Simulation::advanceTo(std::chrono::milliseconds time) {
+    clock->advanceTo(start + time);
+    flushTransitions();
+}
+
+void Simulation::apply(const ScriptEvent &event) {
+    const auto &args = event.args;
+    const auto &cmd = event.command;
+
+    if(cmd == "hardware" && args.size() == 1) {
+        loop->enqueueHardwareState(toHardwareState(args[0]));
+        return;
+    }
+
+    if(cmd == "ambience") {
+        LocalCommand local{};
+        local.type = LocalCommand::Type::AMBIENCE;
+        for(const auto &arg: args) {
+            if(arg.starts_with("curtain=")) {
+                local.curtainUp = toToggle(arg.substr(8));
+            } else if(arg.starts_with("light=")) {
+                local.mainLightOn = toToggle(arg.substr(6));
+            } else {
+                throw std::runtime_error{"invalid ambience argument <" + arg + ">"};
+            }
+        }
+        loop->enqueueLocal(local);
+        return;
+    }
+
+    if(cmd == "curtain" && args.size() == 1 && (args[0] == "up" || args[0] == "down")) {
+        LocalCommand local{};
+        local.type = args[0] == "up" ? LocalCommand::Type::CURTAIN_UP : LocalCommand::Type::CURTAIN_DOWN;
+        loop->enqueueLocal(local);
+        return;
+    }
+
+    if(cmd == "effect" && args.size() == 1 && args[0].size() < LocalCommand::NAME_SIZE) {
+        LocalCommand local{};
+        local.type = LocalCommand::Type::EFFECT;
+        std::strncpy(local.name, args[0].c_str(), LocalCommand::NAME_SIZE - 1);
+        loop->enqueueLocal(local);
+        return;
+    }
+
+    if(cmd == "scene" && args.size() == 1) {
+        loop->enqueueScene(args[0]);
+        return;
+    }
+
+    if(cmd == "button" && args.size() == 1) {
+        backend->setInput(Bridge::PUSH_BUTTON_STATE, false);
+        schedule(elapsed() + parseDuration(args[0]), [this] {
+            backend->setInput(Bridge::PUSH_BUTTON_STATE, true);
+        });
+        return;
+    }
+
+    if(cmd == "bounce" && args.size() == 2 && (args[0] == "light" || args[0] == "button")) {
+        // contact bounce is rather µs than ms
+        Clock::Duration duration = args[1].ends_with("us")
+            ? Clock::Duration{std::chrono::microseconds{std::stoi(args[1])}}
+            : Clock::Duration{parseDuration(args[1])};
+        backend->setBounce(args[0] == "light" ? Bridge::LIGHT_STATE : Bridge::PUSH_BUTTON_STATE, duration);
+        return;
+    }
+
+    if(cmd == "calibrate" && args.size() == 1) {
+        auto duration = std::chrono::duration_cast<std::chrono::seconds>(parseDuration(args[0]));
+        if(duration.count() < 1) {
+            throw std::runtime_error{"calibration takes at least 1s"};
+        }
+        LocalCommand local{};
+        local.type = LocalCommand::Type::CALIBRATE;
+        local.duration = static_cast<std::uint32_t>(duration.count());
+        loop->enqueueLocal(local);
+        return;
+    }
+
+    if(cmd == "light" && args.size() == 1) {
+        // LIGHT_STATE is active low
+        backend->setInput(Bridge::LIGHT_STATE, toToggle(args[0]) != LocalCommand::Toggle::ON);
+        return;
+    }
+
+    if(cmd == "relay" && (args.size() == 1 || (args.size() == 2 && args[0] != "stuck"))) {
+        backend->setRelayStuck(args[0] == "stuck");
+        if(args[0] != "stuck") {
+            backend->setImpulseRelay(
+                Bridge::MAIN_LIGHT, Bridge::LIGHT_STATE, parseDuration(args[0]),
+                args.size() == 2 ? Clock::Duration{parseDuration(args[1])} : Clock::Duration::zero()
+            );
+        }
+        return;
+    }
+
+    if(cmd == "duty" && args.size() == 2) {
+        auto pin = toPwmOutput(args[0]);
+        if(!bridge->isPwm(pin)) {
+            throw std::runtime_error{"<" + args[0] + "> is not driven with PWM"};
+        }
+        // <permille> or <min>..<max>
+        auto dots = args[1].find("..");
+        auto min = std::stoi(args[1].substr(0, dots));
+        auto max = dots == std::string::npos ? min : std::stoi(args[1].substr(dots + 2));
+        auto duty = backend->getDuty(pin, clock->now());
+        if(duty < min || duty > max) {
+            throw std::runtime_error{
+                "duty of <" + args[0] + "> is " + std::to_string(duty) + ", expected " + args[1]
+            };
+        }
+        return;
+    }
+
+    throw std::runtime_error{"invalid command <" + cmd + ">"};
+}
+
+void Simulation::flushTransitions() {
+    auto transitions = backend->takeTransitions();
+    auto changes = backend->takePwmChanges();
+    auto since = [this](Clock::TimePoint time) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(time - start);
+    };
+
+    // both by time, merged; a transition goes first at the same time
+    auto c = changes.begin();
+    for(const auto &t: transitions) {
+        for(; c != changes.end() && c->time < t.time; ++c) {
+            if(pwmHandler) {
+                pwmHandler(since(c->time), *c);
+            }
+        }
+        if(transitionHandler) {
+            transitionHandler(since(t.time), t);
+        }
+    }
+    for(; c != changes.end(); ++c) {
+        if(pwmHandler) {
+            pwmHandler(since(c->time), *c);
+        }
+    }
+}
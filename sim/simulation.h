@@ -0,0 +1,119 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <moba-common/ini.h>
+
+#include "bridge.h"
+#include "debouncecalibration.h"
+#include "eclipsecontrol.h"
+#include "msgloop.h"
+#include "simbackend.h"
+#include "statuscontrol.h"
+#include "virtualclock.h"
+#include "watchdog.h"
+#include "script.h"
+
+/**
+ * The complete daemon (bridge, status- and eclipse-control, message loop
+ * dispatch) on a virtual clock and simulated gpio pins. The main light is
+ * modelled as impulse relay: each pulse on MAIN_LIGHT of at least the relay
+ * response time toggles the light, LIGHT_STATE reports it (low = on).
+ * Outputs set up for PWM report the patterns handed to the backend instead
+ * of transitions; their duty cycle can be checked by the script.
+ */
+class Simulation final {
+public:
+    using TransitionHandler = std::function<void(std::chrono::milliseconds time, const SimulatedBackend::Transition&)>;
+
+    /**
+     * @param stateFile ini file for persistent state, gets written on shutdown
+     */
+    explicit Simulation(const std::string &stateFile);
+    ~Simulation() noexcept;
+
+    Simulation(const Simulation&) = delete;
+    Simulation& operator=(const Simulation&) = delete;
+
+    void setTransitionHandler(TransitionHandler handler);
+
+    using PwmHandler = std::function<void(std::chrono::milliseconds time, const SimulatedBackend::PwmChange&)>;
+
+    /**
+     * Patterns played on PWM outputs, in order with the output transitions.
+     */
+    void setPwmHandler(PwmHandler handler);
+
+    using StateHandler = std::function<void(std::chrono::milliseconds time, const EclipseControl::TransitionRecord&)>;
+
+    /**
+     * State machine transitions of the eclipse control, in order with the
+     * output transitions.
+     */
+    void setStateHandler(StateHandler handler);
+
+    /**
+     * Runs the script and afterwards tail of idle time.
+     */
+    void run(const std::vector<ScriptEvent> &events, std::chrono::milliseconds tail);
+
+    /**
+     * Simulated time since start.
+     */
+    std::chrono::milliseconds elapsed();
+
+    VirtualClockPtr clock;
+    SimulatedBackendPtr backend;
+    BridgePtr bridge;
+    WatchdogPtr watchdog;
+    StatusControlPtr status;
+    EclipseControlPtr eclctr;
+    DebounceCalibrationPtr calibration;
+    std::unique_ptr<MessageLoop> loop;
+
+private:
+    using Action = std::function<void()>;
+
+    // until the script sets another one
+    static constexpr std::chrono::milliseconds RELAY_RESPONSE{30};
+
+    void schedule(std::chrono::milliseconds time, Action action);
+    void advanceTo(std::chrono::milliseconds time);
+    void apply(const ScriptEvent &event);
+    void flushTransitions();
+
+    Clock::TimePoint start;
+    TransitionHandler transitionHandler;
+    PwmHandler pwmHandler;
+
+    // (time, sequence) keeps events of the same time in script order
+    std::map<std::pair<std::chrono::milliseconds, std::uint64_t>, Action> pending;
+    std::uint64_t nextSeq{0};
+};
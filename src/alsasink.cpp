@@ -0,0 +1,81 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "alsasink.h"
+
+#include <stdexcept>
+#include <syslog.h>
+
+AlsaSink::AlsaSink(const std::string &device, unsigned int rate, std::size_t period, ClockPtr clock):
+sampleRate{rate}, pacing{rate, clock} {
+    int err = snd_pcm_open(&pcm, device.c_str(), SND_PCM_STREAM_PLAYBACK, 0);
+    if(err < 0) {
+        throw std::runtime_error{"unable to open <" + device + ">: " + snd_strerror(err)};
+    }
+    auto latency = static_cast<unsigned int>(3 * period * 1000000 / rate);
+    err = snd_pcm_set_params(pcm, SND_PCM_FORMAT_S16_LE, SND_PCM_ACCESS_RW_INTERLEAVED, CHANNELS, rate, 0, latency);
+    if(err < 0) {
+        snd_pcm_close(pcm);
+        throw std::runtime_error{"unable to configure <" + device + ">: " + snd_strerror(err)};
+    }
+}
+
+AlsaSink::~AlsaSink() noexcept {
+    snd_pcm_drain(pcm);
+    snd_pcm_close(pcm);
+}
+
+void AlsaSink::write(const std::int16_t *frames, std::size_t count) {
+    while(count) {
+        auto n = snd_pcm_writei(pcm, frames, count);
+        if(n < 0) {
+            if(n == -EPIPE) {
+                syslog(LOG_WARNING, "sound underrun");
+            }
+            if(snd_pcm_recover(pcm, static_cast<int>(n), 1) < 0) {
+                if(!failed) {
+                    syslog(LOG_ERR, "sound write failed <%s>, muted until the device recovers", snd_strerror(static_cast<int>(n)));
+                    failed = true;
+                }
+                // as long as the frames would play, the mixer must not spin on a dead device
+                pacing.write(frames, count);
+                return;
+            }
+            continue;
+        }
+        if(failed) {
+            syslog(LOG_NOTICE, "sound device recovered");
+            failed = false;
+        }
+        frames += n * CHANNELS;
+        count -= n;
+    }
+}
+
+std::size_t AlsaSink::delay() {
+    if(failed) {
+        return pacing.delay();
+    }
+    snd_pcm_sframes_t frames;
+    if(snd_pcm_delay(pcm, &frames) < 0 || frames < 0) {
+        return 0;
+    }
+    return static_cast<std::size_t>(frames);
+}
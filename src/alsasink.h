@@ -0,0 +1,56 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <string>
+
+#include <alsa/asoundlib.h>
+
+#include "soundsink.h"
+
+class AlsaSink final : public SoundSink {
+public:
+    /**
+     * @param period frames per mixer period, the device buffers three of them
+     * @param clock paces the writes while the device fails
+     * @throws std::runtime_error if the device can't be opened or configured
+     */
+    AlsaSink(const std::string &device, unsigned int rate, std::size_t period, ClockPtr clock);
+    ~AlsaSink() noexcept override;
+
+    AlsaSink(const AlsaSink&) = delete;
+    AlsaSink& operator=(const AlsaSink&) = delete;
+
+    void write(const std::int16_t *frames, std::size_t count) override;
+    std::size_t delay() override;
+
+    unsigned int rate() const override {
+        return sampleRate;
+    }
+
+private:
+    snd_pcm_t *pcm{nullptr};
+    unsigned int sampleRate;
+
+    // takes the frames while the device fails and could not be recovered
+    NullSink pacing;
+    bool failed{false};
+};
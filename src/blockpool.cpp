@@ -0,0 +1,67 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "blockpool.h"
+
+#include <functional>
+#include <new>
+
+BlockPool::BlockPool(std::size_t count, std::size_t blockSize):
+blockSize{(blockSize + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t)} {
+    memory.reset(new std::byte[count * this->blockSize]);
+    end = memory.get() + count * this->blockSize;
+    freeBlocks.reserve(count);
+    for(std::size_t i = count; i-- > 0;) {
+        freeBlocks.push_back(memory.get() + i * this->blockSize);
+    }
+}
+
+void *BlockPool::allocate(std::size_t size) {
+    {
+        std::lock_guard<std::mutex> l{m};
+        if(size <= blockSize && !freeBlocks.empty()) {
+            auto p = freeBlocks.back();
+            freeBlocks.pop_back();
+            return p;
+        }
+        ++overflows;
+    }
+    return ::operator new(size);
+}
+
+void BlockPool::deallocate(void *p) {
+    if(!owns(p)) {
+        ::operator delete(p);
+        return;
+    }
+    std::lock_guard<std::mutex> l{m};
+    freeBlocks.push_back(p);
+}
+
+std::size_t BlockPool::getOverflows() {
+    std::lock_guard<std::mutex> l{m};
+    return overflows;
+}
+
+bool BlockPool::owns(const void *p) const {
+    auto b = static_cast<const std::byte*>(p);
+    std::less<const std::byte*> less;
+    return !less(b, memory.get()) && less(b, end);
+}
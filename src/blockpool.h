@@ -0,0 +1,55 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * Fixed size blocks carved out of one allocation made up front, handed out
+ * and taken back through a free list. A request bigger than a block, or one
+ * with all blocks in use, falls back to the heap (and counts as overflow).
+ */
+class BlockPool final {
+public:
+    BlockPool(std::size_t count, std::size_t blockSize);
+
+    BlockPool(const BlockPool&) = delete;
+    BlockPool& operator=(const BlockPool&) = delete;
+
+    void *allocate(std::size_t size);
+    void deallocate(void *p);
+
+    std::size_t getOverflows();
+
+private:
+    bool owns(const void *p) const;
+
+    const std::size_t blockSize;
+    std::unique_ptr<std::byte[]> memory;
+    const std::byte *end;
+
+    std::mutex m;
+    std::vector<void*> freeBlocks;
+    std::size_t overflows{0};
+};
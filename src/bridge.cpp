@@ -19,8 +19,8 @@
  */
 
 #include "bridge.h"
-#include <thread>
-#include <wiringPi.h>
+
+#include <bit>
 
 /*
  +-----+-----+---------+------+---+---Pi 2---+---+------+---------+-----+-----+
@@ -51,41 +51,147 @@
  +-----+-----+---------+------+---+---Pi 2---+---+------+---------+-----+-----+
  */
 
-Bridge::Bridge() {
-    wiringPiSetup();
+Bridge::Bridge(GpioBackendPtr backend, ClockPtr clock, TelemetryPtr telemetry):
+backend{backend}, clock{clock}, telemetry{telemetry} {
+    for(auto &window: debounceWindows) {
+        window = Clock::Duration{DEFAULT_DEBOUNCE}.count();
+    }
 
-    pinMode(Bridge::CURTAIN_DIR,       OUTPUT);
-    pinMode(Bridge::CURTAIN_ON,        OUTPUT);
-    pinMode(Bridge::MAIN_LIGHT,        OUTPUT);
+    backend->setupOutput(Bridge::CURTAIN_DIR);
+    backend->setupOutput(Bridge::CURTAIN_ON);
+    backend->setupOutput(Bridge::MAIN_LIGHT);
 
-    pinMode(Bridge::STATUS_RED,        OUTPUT);
-    pinMode(Bridge::STATUS_GREEN,      OUTPUT);
+    backend->setupOutput(Bridge::STATUS_RED);
+    backend->setupOutput(Bridge::STATUS_GREEN);
 
-    pinMode(Bridge::LIGHT_STATE,       INPUT);
-    pinMode(Bridge::PUSH_BUTTON_STATE, INPUT);
+    backend->setupInput(Bridge::LIGHT_STATE);
+    backend->setupInput(Bridge::PUSH_BUTTON_STATE);
 }
 
 Bridge::~Bridge() {
 }
 
 void Bridge::setHigh(PinOutputMapping pin) {
-    std::lock_guard<std::mutex> l{m};
-    digitalWrite(pin, HIGH);
+    write(mask(pin), 0);
 }
 
 void Bridge::setLow(PinOutputMapping pin) {
-    std::lock_guard<std::mutex> l{m};
-    digitalWrite(pin, LOW);
+    write(0, mask(pin));
+}
+
+void Bridge::setMask(std::uint32_t highMask, std::uint32_t lowMask) {
+    write(highMask, lowMask);
+}
+
+GpioBackend::Pwm Bridge::setupPwm(PinOutputMapping pin) {
+    auto pwm = backend->setupPwm(pin);
+    if(pwm != GpioBackend::Pwm::NONE) {
+        pwmPins |= mask(pin);
+    }
+    return pwm;
+}
+
+void Bridge::playPwm(PinOutputMapping pin, const PwmPattern &pattern) {
+    if(!isPwm(pin)) {
+        return;
+    }
+    backend->playPwm(pin, pattern);
+    if(telemetry) {
+        telemetry->record(Telemetry::Kind::PWM, pin, pattern.settled());
+    }
 }
 
 bool Bridge::getDebounced(PinInputMapping pin) {
-    std::lock_guard<std::mutex> l{m};
-    int j = 0;
-    for(int i = 0; i < 6; ++i) {
-        if(digitalRead(pin)) {
-            ++j;
+    auto window = getDebounceWindow(pin);
+    bool level = backend->read(pin);
+
+    if(window > Clock::Duration::zero()) {
+        auto stableSince = clock->now();
+        auto giveUp = stableSince + 4 * window;
+        // bounded by count as well, the clock need not move on (released virtual clock)
+        auto samplesLeft = 4 * ((window + DEBOUNCE_SAMPLE - Clock::Duration{1}) / DEBOUNCE_SAMPLE);
+        while(samplesLeft--) {
+            clock->sleepFor(DEBOUNCE_SAMPLE);
+            bool sample = backend->read(pin);
+            auto now = clock->now();
+            if(sample != level) {
+                level = sample;
+                stableSince = now;
+            } else if(now - stableSince >= window) {
+                break;
+            }
+            // still bouncing, take what is there
+            if(now >= giveUp) {
+                break;
+            }
         }
-        std::this_thread::sleep_for(std::chrono::microseconds(25));
     }
-    return j > 3;
+    if(telemetry) {
+        recordInput(pin, level);
+    }
+    return level;
+}
+
+bool Bridge::getRaw(PinInputMapping pin) {
+    return backend->read(pin);
+}
+
+void Bridge::recordDebounced(PinInputMapping pin, bool level) {
+    if(telemetry) {
+        recordInput(pin, level);
+    }
+}
+
+void Bridge::setDebounceWindow(PinInputMapping pin, Clock::Duration window) {
+    debounceWindows[pin] = window.count();
+}
+
+Clock::Duration Bridge::getDebounceWindow(PinInputMapping pin) {
+    return Clock::Duration{debounceWindows[pin].load()};
+}
+
+void Bridge::park() {
+    auto high = parkHigh.load();
+    auto pwm = pwmPins.load();
+    write(high, parkLow);
+    for(auto pins = pwm & (high | parkLow); pins; pins &= pins - 1) {
+        auto pin = std::countr_zero(pins);
+        playPwm(static_cast<PinOutputMapping>(pin), PwmPattern::level(high & (1u << pin) ? PwmPattern::FULL : 0));
+    }
+}
+
+void Bridge::setParkLevels(std::uint32_t highMask, std::uint32_t lowMask) {
+    parkHigh = highMask;
+    parkLow = lowMask;
+}
+
+void Bridge::write(std::uint32_t highMask, std::uint32_t lowMask) {
+    auto pwm = pwmPins.load(std::memory_order_relaxed);
+    highMask &= ~pwm;
+    lowMask &= ~pwm;
+    backend->write(highMask, lowMask);
+    if(!telemetry) {
+        return;
+    }
+    auto before = outputs.load(std::memory_order_relaxed);
+    std::uint32_t after;
+    do {
+        after = (before | highMask) & ~lowMask;
+    } while(!outputs.compare_exchange_weak(before, after, std::memory_order_relaxed));
+
+    for(auto changed = before ^ after; changed; changed &= changed - 1) {
+        auto pin = std::countr_zero(changed);
+        telemetry->record(Telemetry::Kind::OUTPUT, pin, (after >> pin) & 1);
+    }
+}
+
+void Bridge::recordInput(PinInputMapping pin, bool level) {
+    std::uint32_t m = 1u << pin;
+    auto before = level ? inputs.fetch_or(m, std::memory_order_relaxed) : inputs.fetch_and(~m, std::memory_order_relaxed);
+    bool known = knownInputs.fetch_or(m, std::memory_order_relaxed) & m;
+
+    // the first reading as well, so the server knows the level to begin with
+    if(!known || static_cast<bool>(before & m) != level) {
+        telemetry->record(Telemetry::Kind::INPUT_EDGE, pin, level);
+    }
 }
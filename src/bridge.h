@@ -20,8 +20,14 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <memory>
-#include <mutex>
+
+#include "clock.h"
+#include "gpiobackend.h"
+#include "telemetry.h"
 
 class Bridge final {
 public:
@@ -42,19 +48,102 @@ public:
         CURTAIN_ON   = 21,       // PIN 29
     };
 
-    Bridge();
+    /**
+     * telemetry may be null, otherwise every output transition and every
+     * change of a debounced input is recorded
+     */
+    Bridge(GpioBackendPtr backend, ClockPtr clock, TelemetryPtr telemetry);
 
     ~Bridge();
 
     Bridge(const Bridge&) = delete;
     Bridge& operator=(const Bridge&) = delete;
 
+    static constexpr std::uint32_t mask(PinOutputMapping pin) {
+        return 1u << pin;
+    }
+
     void setHigh(PinOutputMapping pin);
     void setLow(PinOutputMapping pin);
+
+    /**
+     * Switches several outputs with a single backend write,
+     * e.g. setMask(mask(STATUS_RED), mask(STATUS_GREEN))
+     */
+    void setMask(std::uint32_t highMask, std::uint32_t lowMask);
+
+    /**
+     * Hands an output over to PWM if the backend can drive it so; setHigh,
+     * setLow and setMask leave it alone from then on.
+     */
+    GpioBackend::Pwm setupPwm(PinOutputMapping pin);
+
+    bool isPwm(PinOutputMapping pin) const {
+        return pwmPins & mask(pin);
+    }
+
+    /**
+     * The backend plays pattern on a PWM output, no further calls needed.
+     */
+    void playPwm(PinOutputMapping pin, const PwmPattern &pattern);
+
+    // debounced reads sample the input this often
+    static constexpr std::chrono::microseconds DEBOUNCE_SAMPLE{25};
+
+    // the former fixed filter, 6 samples
+    static constexpr std::chrono::microseconds DEFAULT_DEBOUNCE{150};
+
+    /**
+     * Samples pin until its level was stable for the pin's debounce window,
+     * at most 4 windows. A window of 0 is a single read.
+     */
     bool getDebounced(PinInputMapping pin);
 
+    /**
+     * Single read, no debouncing, no telemetry (input characterisation).
+     */
+    bool getRaw(PinInputMapping pin);
+
+    /**
+     * Records a level the caller debounced from getRaw() reads itself,
+     * as getDebounced() does.
+     */
+    void recordDebounced(PinInputMapping pin, bool level);
+
+    void setDebounceWindow(PinInputMapping pin, Clock::Duration window);
+    Clock::Duration getDebounceWindow(PinInputMapping pin);
+
+    /**
+     * Drives all outputs into their park levels with a single write, PWM
+     * outputs to full or no brightness. By default: curtain motor off, no
+     * light impulse (a dimmed light goes off), status red.
+     */
+    void park();
+
+    void setParkLevels(std::uint32_t highMask, std::uint32_t lowMask);
+
 private:
-    std::mutex m;
+    void write(std::uint32_t highMask, std::uint32_t lowMask);
+    void recordInput(PinInputMapping pin, bool level);
+
+    GpioBackendPtr backend;
+    ClockPtr clock;
+    TelemetryPtr telemetry;
+
+    // for telemetry only: last written outputs, last debounced inputs
+    std::atomic<std::uint32_t> outputs{0};
+    std::atomic<std::uint32_t> inputs{0};
+    std::atomic<std::uint32_t> knownInputs{0};
+
+    std::atomic<std::uint32_t> pwmPins{0};
+
+    // Clock::Duration ticks, per wiringPi pin
+    std::array<std::atomic<Clock::Duration::rep>, 32> debounceWindows;
+
+    std::atomic<std::uint32_t> parkHigh{mask(STATUS_RED)};
+    std::atomic<std::uint32_t> parkLow{
+        mask(STATUS_GREEN) | mask(MAIN_LIGHT) | mask(CURTAIN_ON) | mask(CURTAIN_DIR)
+    };
 };
 
 using BridgePtr = std::shared_ptr<Bridge>;
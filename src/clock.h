@@ -0,0 +1,104 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/**
+ * Source of time for all control threads. Every subsystem sleeps and starts
+ * its threads through the clock, so the whole daemon can run on virtual time
+ * (see VirtualClock).
+ */
+class Clock {
+public:
+    using Duration = std::chrono::steady_clock::duration;
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    /**
+     * Lets another thread cut a sleepFor(d, alarm) short. A wake() while the
+     * owner is not sleeping makes its next sleep return at once.
+     */
+    class Alarm final {
+    public:
+        Alarm() = default;
+
+        Alarm(const Alarm&) = delete;
+        Alarm& operator=(const Alarm&) = delete;
+
+    private:
+        friend class SystemClock;
+        friend class VirtualClock;
+
+        std::mutex m;
+        std::condition_variable cv;
+        bool signaled{false};
+
+        // VirtualClock only: ticket of the sleeping owner
+        bool sleeping{false};
+        TimePoint wakeAt{};
+        std::uint64_t seq{0};
+    };
+
+    virtual ~Clock() noexcept = default;
+
+    virtual TimePoint now() = 0;
+    virtual void sleepFor(Duration d) = 0;
+    virtual void sleepFor(Duration d, Alarm &alarm) = 0;
+    virtual void wake(Alarm &alarm) = 0;
+    virtual std::thread startThread(std::function<void()> fn) = 0;
+};
+
+using ClockPtr = std::shared_ptr<Clock>;
+
+class SystemClock final: public Clock {
+public:
+    TimePoint now() override {
+        return std::chrono::steady_clock::now();
+    }
+
+    void sleepFor(Duration d) override {
+        std::this_thread::sleep_for(d);
+    }
+
+    void sleepFor(Duration d, Alarm &alarm) override {
+        std::unique_lock<std::mutex> l{alarm.m};
+        alarm.cv.wait_for(l, d, [&alarm]{return alarm.signaled;});
+        alarm.signaled = false;
+    }
+
+    void wake(Alarm &alarm) override {
+        {
+            std::lock_guard<std::mutex> l{alarm.m};
+            alarm.signaled = true;
+        }
+        alarm.cv.notify_one();
+    }
+
+    std::thread startThread(std::function<void()> fn) override {
+        return std::thread{std::move(fn)};
+    }
+};
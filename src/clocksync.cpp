@@ -0,0 +1,205 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "clocksync.h"
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <syslog.h>
+
+ClockSync::ClockSync(moba::IniPtr ini, ClockPtr clock): clock{clock} {
+    auto m = ini->getString("sync", "mode", "off");
+    if(m == "reference") {
+        mode = Mode::REFERENCE;
+    } else if(m == "follower") {
+        mode = Mode::FOLLOWER;
+    } else {
+        if(m != "off") {
+            syslog(LOG_ERR, "sync: invalid mode <%s>, sync is off", m.c_str());
+        }
+        mode = Mode::OFF;
+    }
+    node = static_cast<std::uint8_t>(std::clamp(ini->getInt("sync", "node", 0), 0, 255));
+    interval = std::chrono::milliseconds{std::max(ini->getInt("sync", "interval", 2000), 10)};
+    lead = std::chrono::milliseconds{std::max(ini->getInt("sync", "lead", 250), 0)};
+}
+
+ClockSync::~ClockSync() noexcept {
+    stop();
+}
+
+void ClockSync::start(PingSender send) {
+    if(mode != Mode::FOLLOWER) {
+        return;
+    }
+    running = true;
+    pingThread = clock->startThread([this, send = std::move(send)]{pingControl(send);});
+}
+
+void ClockSync::stop() {
+    running = false;
+    clock->wake(alarm);
+    if(pingThread.joinable()) {
+        pingThread.join();
+    }
+}
+
+void ClockSync::pingControl(PingSender send) {
+    while(running) {
+        try {
+            send(makePing());
+        } catch(const std::exception &e) {
+            // not connected yet, the next ping will do
+            syslog(LOG_DEBUG, "sync: ping failed <%s>", e.what());
+        }
+        clock->sleepFor(interval, alarm);
+    }
+}
+
+ClockSync::Ping ClockSync::makePing() {
+    return Ping{node, nextSeq++, localNow()};
+}
+
+ClockSync::Pong ClockSync::answer(const Ping &ping) {
+    auto received = localNow();
+    return Pong{ping.node, ping.seq, ping.sent, received, localNow()};
+}
+
+void ClockSync::onPong(const Pong &pong) {
+    auto now = localNow();
+    if(mode != Mode::FOLLOWER || pong.node != node) {
+        return;
+    }
+
+    // t1 sent, t2 received, t3 replied, t4 now
+    auto delay = std::max<std::int64_t>((now - pong.sent) - (pong.replied - pong.received), 0);
+    auto offset = ((pong.received - pong.sent) + (pong.replied - now)) / 2;
+    auto local = pong.sent + (now - pong.sent) / 2;
+
+    std::lock_guard<std::mutex> l{m};
+    if(pong.seq <= lastSeq) {
+        return;
+    }
+    lastSeq = pong.seq;
+    ++pongs;
+
+    // the reference restarted (new clock), or this node's clock jumped
+    if(!used.empty() && std::abs(offset - (a + b * (local - base))) > std::chrono::nanoseconds{MAX_STEP}.count()) {
+        syslog(LOG_WARNING, "sync: offset stepped by %lld ms, restarting", static_cast<long long>((offset - a) / 1000000));
+        recent.clear();
+        used.clear();
+    }
+
+    recent.push_back(Sample{pong.seq, local, offset, delay});
+    if(recent.size() > FILTER) {
+        recent.pop_front();
+    }
+
+    // clock filter: only the round trip with the least delay counts, each once
+    auto best = *std::min_element(recent.begin(), recent.end(), [](const Sample &x, const Sample &y) {
+        return x.delay < y.delay;
+    });
+    if(!used.empty() && used.back().seq >= best.seq) {
+        return;
+    }
+    used.push_back(best);
+    if(used.size() > FIT) {
+        used.pop_front();
+    }
+    fit();
+}
+
+void ClockSync::fit() {
+    // weighted least squares: the offset of a round trip is off by up to half of
+    // its delay beyond the least one seen, such samples count accordingly less
+    auto least = std::min_element(used.begin(), used.end(), [](const Sample &x, const Sample &y) {
+        return x.delay < y.delay;
+    })->delay;
+    // x relative to the newest sample keeps the doubles small
+    base = used.back().local;
+    double sw = 0.0;
+    double sx = 0.0;
+    double sy = 0.0;
+    for(const auto &s: used) {
+        double excess = static_cast<double>(s.delay - least) / std::chrono::nanoseconds{JITTER}.count();
+        double w = 1.0 / (1.0 + excess * excess);
+        sw += w;
+        sx += w * (s.local - base);
+        sy += w * s.offset;
+    }
+    double mx = sx / sw;
+    double my = sy / sw;
+    double sxx = 0.0;
+    double sxy = 0.0;
+    for(const auto &s: used) {
+        double excess = static_cast<double>(s.delay - least) / std::chrono::nanoseconds{JITTER}.count();
+        double w = 1.0 / (1.0 + excess * excess);
+        double dx = (s.local - base) - mx;
+        sxx += w * dx * dx;
+        sxy += w * dx * (s.offset - my);
+    }
+    b = sxx > 0.0 ? std::clamp(sxy / sxx, -MAX_SKEW, MAX_SKEW) : 0.0;
+    a = my - b * mx;
+}
+
+bool ClockSync::isSynced() {
+    if(mode == Mode::REFERENCE) {
+        return true;
+    }
+    std::lock_guard<std::mutex> l{m};
+    return used.size() >= MIN_SAMPLES;
+}
+
+std::int64_t ClockSync::referenceNow() {
+    auto now = localNow();
+    if(mode != Mode::FOLLOWER) {
+        return now;
+    }
+    std::lock_guard<std::mutex> l{m};
+    return now + std::llround(a + b * (now - base));
+}
+
+Clock::TimePoint ClockSync::toLocal(std::int64_t at) {
+    std::int64_t local = at;
+    if(mode == Mode::FOLLOWER) {
+        // at = local + a + b * (local - base)
+        std::lock_guard<std::mutex> l{m};
+        local = base + std::llround((at - base - a) / (1.0 + b));
+    }
+    return Clock::TimePoint{std::chrono::nanoseconds{local}};
+}
+
+ClockSync::Stats ClockSync::getStats() {
+    auto now = localNow();
+    bool synced = isSynced();
+    std::lock_guard<std::mutex> l{m};
+    return Stats{
+        synced,
+        Clock::Duration{std::llround(a + b * (now - base))},
+        b * 1e6,
+        Clock::Duration{used.empty() ? 0 : used.back().delay},
+        pongs
+    };
+}
+
+std::int64_t ClockSync::localNow() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(clock->now().time_since_epoch()).count();
+}
@@ -0,0 +1,194 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <moba-common/ini.h>
+
+#include "clock.h"
+
+/**
+ * NTP like synchronisation of the monotonic clocks of several environment
+ * nodes to the one of a reference node, so an effect can be started at the
+ * same moment everywhere. Configured in section [sync]:
+ *   mode=off (default) | reference | follower
+ *   node=<0..255>       unique per layout
+ *   interval=<ms>       between two pings of a follower
+ *   lead=<ms>           how far ahead a synced effect is scheduled
+ *
+ * A follower pings the reference, which answers with its receive and send
+ * time. Each round trip gives an offset and a delay; of the last FILTER round
+ * trips only the one with the smallest delay is used (the least queueing, so
+ * the least asymmetry). A straight line fitted through the last FIT of those,
+ * weighted by how close their delay is to the least one, gives offset and
+ * skew, so the mapping stays right between two pings.
+ *
+ * The transport is left to the caller (endpoint, or a simulated network).
+ */
+class ClockSync final {
+public:
+    enum class Mode {
+        OFF,
+        REFERENCE,
+        FOLLOWER,
+    };
+
+    // times in ns of the sender's monotonic clock
+    struct Ping {
+        std::uint8_t node;
+        std::uint32_t seq;
+        std::int64_t sent;
+    };
+
+    struct Pong {
+        // who pinged
+        std::uint8_t node;
+        std::uint32_t seq;
+        std::int64_t sent;
+        // reference clock
+        std::int64_t received;
+        std::int64_t replied;
+    };
+
+    struct Stats {
+        bool synced;
+        // reference - local, now
+        Clock::Duration offset;
+        double skewPpm;
+        // round trip of the last sample used
+        Clock::Duration delay;
+        unsigned int pongs;
+    };
+
+    static constexpr std::size_t FILTER = 8;
+    static constexpr std::size_t FIT = 16;
+
+    // samples used before the mapping counts as synced
+    static constexpr std::size_t MIN_SAMPLES = 3;
+
+    static constexpr double MAX_SKEW = 500e-6;
+
+    // delay beyond the least one at which a sample counts half in the fit
+    static constexpr std::chrono::microseconds JITTER{200};
+
+    // a sample that far off the fit discards all samples so far
+    static constexpr std::chrono::milliseconds MAX_STEP{1000};
+
+    using PingSender = std::function<void(const Ping&)>;
+
+    ClockSync(moba::IniPtr ini, ClockPtr clock);
+    ~ClockSync() noexcept;
+
+    ClockSync(const ClockSync&) = delete;
+    ClockSync& operator=(const ClockSync&) = delete;
+
+    /**
+     * Starts pinging (follower only).
+     */
+    void start(PingSender send);
+    void stop();
+
+    Mode getMode() const {
+        return mode;
+    }
+
+    std::uint8_t getNode() const {
+        return node;
+    }
+
+    Clock::Duration getLead() const {
+        return lead;
+    }
+
+    Ping makePing();
+
+    /**
+     * Reference only, to be called as soon as the ping arrived.
+     */
+    Pong answer(const Ping &ping);
+
+    /**
+     * Pongs for other nodes and duplicates are ignored.
+     */
+    void onPong(const Pong &pong);
+
+    /**
+     * True on the reference and on a follower with enough samples, never
+     * with mode off.
+     */
+    bool isSynced();
+
+    /**
+     * Reference clock in ns.
+     */
+    std::int64_t referenceNow();
+
+    /**
+     * Local time of reference clock time at.
+     */
+    Clock::TimePoint toLocal(std::int64_t at);
+
+    Stats getStats();
+
+private:
+    struct Sample {
+        std::uint32_t seq;
+        // local clock at the middle of the round trip
+        std::int64_t local;
+        std::int64_t offset;
+        std::int64_t delay;
+    };
+
+    std::int64_t localNow();
+    void pingControl(PingSender send);
+    void fit();
+
+    ClockPtr clock;
+    Mode mode;
+    std::uint8_t node;
+    Clock::Duration interval;
+    Clock::Duration lead;
+
+    std::atomic<std::uint32_t> nextSeq{1};
+
+    std::mutex m;
+    std::deque<Sample> recent;
+    std::deque<Sample> used;
+    std::uint32_t lastSeq{0};
+    unsigned int pongs{0};
+    // offset(local) = a + b * (local - base)
+    std::int64_t base{0};
+    double a{0.0};
+    double b{0.0};
+
+    Clock::Alarm alarm;
+    std::atomic<bool> running{false};
+    std::thread pingThread;
+};
+
+using ClockSyncPtr = std::shared_ptr<ClockSync>;
@@ -0,0 +1,168 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "debouncecalibration.h"
+
+#include <algorithm>
+#include <syslog.h>
+
+namespace {
+    double toUs(Clock::Duration d) {
+        return std::chrono::duration<double, std::micro>(d).count();
+    }
+}
+
+DebounceCalibration::DebounceCalibration(BridgePtr bridge, moba::IniPtr ini, ClockPtr clock):
+bridge{bridge}, ini{ini}, clock{clock} {
+    for(const auto &input: INPUTS) {
+        auto us = ini->getInt("debounce", input.key, -1);
+        if(us >= 0) {
+            bridge->setDebounceWindow(input.pin, std::min<Clock::Duration>(std::chrono::microseconds{us}, MAX_WINDOW));
+        }
+    }
+}
+
+DebounceCalibration::~DebounceCalibration() noexcept {
+    stop();
+}
+
+bool DebounceCalibration::start(Clock::Duration duration) {
+    std::lock_guard<std::mutex> l{m};
+    if(running) {
+        return false;
+    }
+    if(sampleThread.joinable()) {
+        sampleThread.join();
+    }
+    running = true;
+    aborted = false;
+    syslog(LOG_NOTICE, "debounce calibration started, operate the inputs now");
+    sampleThread = clock->startThread([this, duration]{sample(duration);});
+    return true;
+}
+
+void DebounceCalibration::stop() {
+    aborted = true;
+    std::thread t;
+    {
+        // the sampling thread takes m to hand over its results
+        std::lock_guard<std::mutex> l{m};
+        t = std::move(sampleThread);
+    }
+    if(t.joinable()) {
+        t.join();
+    }
+}
+
+std::vector<DebounceCalibration::Result> DebounceCalibration::getResults() {
+    std::lock_guard<std::mutex> l{m};
+    return results;
+}
+
+void DebounceCalibration::sample(Clock::Duration duration) {
+    struct Track {
+        bool level;
+        bool bouncing;
+        Clock::TimePoint first;
+        Clock::TimePoint last;
+        std::vector<Clock::Duration> bounces;
+    };
+
+    std::vector<Track> tracks;
+    for(const auto &input: INPUTS) {
+        tracks.push_back(Track{bridge->getRaw(input.pin), false, {}, {}, {}});
+    }
+
+    auto start = clock->now();
+    auto end = start + duration;
+    std::size_t samples = 0;
+    auto now = start;
+    while(!aborted && now < end) {
+        clock->sleepFor(SAMPLE_INTERVAL);
+        now = clock->now();
+        ++samples;
+        for(std::size_t i = 0; i < tracks.size(); ++i) {
+            auto &t = tracks[i];
+            bool level = bridge->getRaw(INPUTS[i].pin);
+            if(level != t.level) {
+                t.level = level;
+                if(!t.bouncing) {
+                    t.bouncing = true;
+                    t.first = now;
+                }
+                t.last = now;
+            } else if(t.bouncing && now - t.last >= QUIET) {
+                t.bouncing = false;
+                t.bounces.push_back(t.last - t.first);
+            }
+        }
+    }
+
+    if(aborted) {
+        syslog(LOG_WARNING, "debounce calibration aborted");
+        running = false;
+        return;
+    }
+
+    // the real sample period, a bounce may end unseen up to one period after the last transition
+    auto resolution = samples ? (now - start) / static_cast<Clock::Duration::rep>(samples) : Clock::Duration{SAMPLE_INTERVAL};
+
+    std::vector<Result> r;
+    for(std::size_t i = 0; i < tracks.size(); ++i) {
+        r.push_back(evaluate(INPUTS[i].pin, tracks[i].bounces, resolution));
+        const auto &res = r.back();
+        if(!res.applied) {
+            syslog(LOG_WARNING, "debounce <%s>: only %zu edges, window left unchanged", INPUTS[i].key, res.edges);
+            continue;
+        }
+        bridge->setDebounceWindow(res.pin, res.window);
+        ini->setInt("debounce", INPUTS[i].key, static_cast<int>(res.window / std::chrono::microseconds{1}));
+        syslog(
+            LOG_NOTICE, "debounce <%s>: %zu edges, bounce p50 %.0f µs, p99 %.0f µs, max %.0f µs -> window %.0f µs",
+            INPUTS[i].key, res.edges, toUs(res.p50), toUs(res.p99), toUs(res.max), toUs(res.window)
+        );
+    }
+    {
+        std::lock_guard<std::mutex> l{m};
+        results = std::move(r);
+    }
+    running = false;
+}
+
+DebounceCalibration::Result DebounceCalibration::evaluate(
+    Bridge::PinInputMapping pin, std::vector<Clock::Duration> &bounces, Clock::Duration resolution
+) {
+    Result res{pin, bounces.size(), {}, {}, {}, bridge->getDebounceWindow(pin), false};
+    if(bounces.size() < MIN_EDGES) {
+        return res;
+    }
+    std::sort(bounces.begin(), bounces.end());
+    res.p50 = bounces[bounces.size() / 2];
+    res.p99 = bounces[std::min(bounces.size() - 1, bounces.size() * 99 / 100)];
+    res.max = bounces.back();
+    res.applied = true;
+
+    // the worst bounce seen plus half, rounded up to whole debounce samples; a bounce of 0 only
+    // means none was seen within one sample period, so resolution is the margin even then
+    auto window = res.max + res.max / 2 + resolution;
+    auto steps = (window + Bridge::DEBOUNCE_SAMPLE - Clock::Duration{1}) / Bridge::DEBOUNCE_SAMPLE;
+    res.window = std::min<Clock::Duration>(steps * Bridge::DEBOUNCE_SAMPLE, MAX_WINDOW);
+    return res;
+}
@@ -0,0 +1,122 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <moba-common/ini.h>
+
+#include "bridge.h"
+#include "clock.h"
+
+/**
+ * Input characterisation: samples the raw inputs for a while, measures how
+ * long each edge bounces and picks the shortest debounce window per pin that
+ * still covers every bounce seen, with a margin. Bounces shorter than the
+ * sample period go unseen, so a window is never shorter than that. The
+ * windows go to the bridge and into section [debounce] of the state file
+ * (µs, 0: single read, only if set by hand):
+ *   light_state=<µs>
+ *   push_button_state=<µs>
+ *
+ * Meanwhile the inputs have to be operated, e.g. the button pressed and the
+ * light switched a few times.
+ */
+class DebounceCalibration final {
+public:
+    // the raw inputs are read this often
+    static constexpr std::chrono::microseconds SAMPLE_INTERVAL{20};
+
+    // an edge is over once the input was stable for that long
+    static constexpr std::chrono::milliseconds QUIET{20};
+
+    // fewer edges of a pin leave its window untouched
+    static constexpr std::size_t MIN_EDGES = 4;
+
+    static constexpr std::chrono::milliseconds MAX_WINDOW{20};
+
+    struct Result {
+        Bridge::PinInputMapping pin;
+        std::size_t edges;
+        // bounce: first to last transition of an edge
+        Clock::Duration p50;
+        Clock::Duration p99;
+        Clock::Duration max;
+        Clock::Duration window;
+        bool applied;
+    };
+
+    /**
+     * Applies the windows stored in the state file to bridge.
+     */
+    DebounceCalibration(BridgePtr bridge, moba::IniPtr ini, ClockPtr clock);
+    ~DebounceCalibration() noexcept;
+
+    DebounceCalibration(const DebounceCalibration&) = delete;
+    DebounceCalibration& operator=(const DebounceCalibration&) = delete;
+
+    /**
+     * Samples for duration in a thread of its own, then applies and saves.
+     * @return false if a calibration is still running
+     */
+    bool start(Clock::Duration duration);
+
+    /**
+     * Aborts a running calibration, nothing is applied then.
+     */
+    void stop();
+
+    /**
+     * Of the last finished calibration.
+     */
+    std::vector<Result> getResults();
+
+private:
+    struct Input {
+        Bridge::PinInputMapping pin;
+        const char *key;
+    };
+
+    static constexpr Input INPUTS[] = {
+        {Bridge::LIGHT_STATE,       "light_state"},
+        {Bridge::PUSH_BUTTON_STATE, "push_button_state"},
+    };
+
+    void sample(Clock::Duration duration);
+    Result evaluate(Bridge::PinInputMapping pin, std::vector<Clock::Duration> &bounces, Clock::Duration resolution);
+
+    BridgePtr bridge;
+    moba::IniPtr ini;
+    ClockPtr clock;
+
+    std::mutex m;
+    std::vector<Result> results;
+    std::thread sampleThread;
+    std::atomic<bool> running{false};
+    std::atomic<bool> aborted{false};
+};
+
+using DebounceCalibrationPtr = std::shared_ptr<DebounceCalibration>;
@@ -20,169 +20,458 @@
 
 #include "eclipsecontrol.h"
 
+#include <algorithm>
+#include <cstdlib>
 #include <syslog.h>
-#include <thread>
+#include <utility>
 
-EclipseControl::EclipseControl(BridgePtr bridge, moba::IniPtr ini): bridge{bridge}, ini{ini} {
-    curtainPos = ini->getInt("curtain", "pos", 0);
-    curtainThread = std::thread{&EclipseControl::curtainControl, this};
-    mainLightThread = std::thread{&EclipseControl::mainLightControl, this};
+namespace {
+    using CS = EclipseControl::CurtainState;
+    using CE = EclipseControl::CurtainEvent;
+
+    constexpr bool isRunning(CS state) {
+        return
+            state == CS::RUNNING_UP || state == CS::RUNNING_DOWN ||
+            state == CS::ECLIPSE_CLOSING || state == CS::ECLIPSE_OPENING;
+    }
+
+    constexpr bool isDown(CS state) {
+        return state == CS::RUNNING_DOWN || state == CS::ECLIPSE_CLOSING;
+    }
+
+    const char *toString(EclipseControl::CurtainState state) {
+        constexpr const char *names[] = {
+            "IDLE", "RUNNING_UP", "RUNNING_DOWN", "ECLIPSE_CLOSING", "ECLIPSED", "ECLIPSE_OPENING"
+        };
+        return names[static_cast<std::size_t>(state)];
+    }
+
+    const char *toString(EclipseControl::CurtainEvent event) {
+        constexpr const char *names[] = {
+            "UP", "DOWN", "ECLIPSE_START", "ECLIPSE_STOP", "END_REACHED", "TO_UP", "TO_DOWN"
+        };
+        return names[static_cast<std::size_t>(event)];
+    }
+
+    const char *toString(EclipseControl::LightState state) {
+        constexpr const char *names[] = {"IDLE", "PULSING", "CONFIRMING"};
+        return names[static_cast<std::size_t>(state)];
+    }
+
+    const char *toString(EclipseControl::LightEvent event) {
+        constexpr const char *names[] = {"SWITCH", "PULSE_DONE", "CONFIRMED", "TIMEOUT"};
+        return names[static_cast<std::size_t>(event)];
+    }
+
+    std::int64_t toNs(Clock::TimePoint t) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+    }
+}
+
+EclipseControl::EclipseControl(
+    BridgePtr bridge, moba::IniPtr ini, ClockPtr clock, WatchdogPtr watchdog, TelemetryPtr telemetry
+): bridge{bridge}, ini{ini}, clock{clock}, telemetry{telemetry}, loop{clock, watchdog->registerLoop("eclipse", std::chrono::milliseconds{1000})} {
+    curtainPos = std::clamp(ini->getInt("curtain", "pos", 0), 0, CURTAIN_POS_MAX);
+
+    lightTimeout = std::chrono::milliseconds{std::max(ini->getInt("light", "timeout", 250), 0)};
+    lightRetries = std::clamp(ini->getInt("light", "retries", 2), 0, 10);
+    lightBackoff = std::chrono::milliseconds{std::max(ini->getInt("light", "backoff", 200), 0)};
+    lightStats.response = std::chrono::milliseconds{std::clamp(ini->getInt("light", "response", 0), 0, static_cast<int>(MAX_PULSE.count()))};
+    lightStats.pulse = pulseFor(lightStats.response);
+
+    if(ini->getString("light", "driver", "relay") == "dimmer") {
+        dimmer = bridge->setupPwm(Bridge::MAIN_LIGHT) != GpioBackend::Pwm::NONE;
+        if(!dimmer) {
+            syslog(LOG_ERR, "main light: no PWM on MAIN_LIGHT, driven as impulse relay");
+        }
+    }
+    lightBrightness = std::clamp<int>(ini->getInt("light", "brightness", PwmPattern::FULL), 0, PwmPattern::FULL);
+    // a whole curtain run by default
+    auto run = std::chrono::duration_cast<std::chrono::milliseconds>(CURTAIN_POS_MAX * CURTAIN_TICK).count();
+    lightFade = std::chrono::milliseconds{std::max(ini->getInt("light", "fade", 500), 0)};
+    duskRamp = std::chrono::milliseconds{std::max(ini->getInt("light", "dusk", run), 0)};
+    dawnRamp = std::chrono::milliseconds{std::max(ini->getInt("light", "dawn", run), 0)};
+    if(dimmer) {
+        // no feedback, a dimmer starts dark
+        dimmerStart = clock->now();
+        bridge->playPwm(Bridge::MAIN_LIGHT, dimmerPattern);
+    }
+
+    dispatcher = receiveCommands();
+    loop.spawn(dispatcher);
+    loop.start();
 }
 
 EclipseControl::~EclipseControl() {
-    ini->setInt("curtain", "pos", curtainPos);
-    running = false;
-    curtainThread.join();
-    mainLightThread.join();
+    stop();
+    saveState();
 }
 
-void EclipseControl::startEclipse() {
-    if(eclipsed) {
-        syslog(LOG_WARNING, "startEclipse: allready eclipsed!");
-        return;
+void EclipseControl::stop() {
+    loop.stop();
+    if(!curtainTask.done()) {
+        syslog(LOG_INFO, "curtain stopped at <%d>", curtainPos.load());
     }
-    eclipsed = true;
-    mainLightWasOn = !getDebounced(Bridge::LIGHT_STATE);
-    if(!mainLightWasOn) {
-        mainLightOff();
+    // the guards of the tasks switch motor and relay off
+    curtainTask.cancel();
+    lightTask.cancel();
+    dispatcher.cancel();
+}
+
+void EclipseControl::saveState() {
+    ini->setInt("curtain", "pos", curtainPos);
+
+    auto response = getLightStats().response;
+    if(response != Clock::Duration::zero()) {
+        // rounded up, a pulse sized from it must not get too short
+        ini->setInt("light", "response", std::chrono::ceil<std::chrono::milliseconds>(response).count());
     }
-    curtainState = CurtainState::POS_DOWN;
+}
+
+EclipseControl::LightStats EclipseControl::getLightStats() {
+    std::lock_guard<std::mutex> l{lightStatsMutex};
+    return lightStats;
+}
+
+void EclipseControl::setTransitionObserver(TransitionObserver observer) {
+    std::lock_guard<std::mutex> l{observerMutex};
+    this->observer = std::move(observer);
+}
+
+void EclipseControl::startEclipse() {
+    post(Command::ECLIPSE_START);
 }
 
 void EclipseControl::stopEclipse() {
-    if(!eclipsed) {
-        syslog(LOG_WARNING, "stopEclipse: allready stopped!");
-        return;
-    }
-    eclipsed = false;
-    if(mainLightWasOn) {
-        mainLightOn();
-    }
-    curtainState = CurtainState::POS_UP;
+    post(Command::ECLIPSE_STOP);
 }
 
 void EclipseControl::mainLightOn() {
-    syslog(LOG_INFO, "mainLightOn");
-    mainLightState = MainLightState::ON;
+    post(Command::LIGHT_ON);
 }
 
 void EclipseControl::mainLightOff() {
-    syslog(LOG_INFO, "mainLightOff");
-    mainLightState = MainLightState::OFF;
+    post(Command::LIGHT_OFF);
 }
 
 void EclipseControl::curtainRunningUp() {
-    syslog(LOG_INFO, "curtainRunningUp");
-    if(eclipsed) {
-        syslog(LOG_WARNING, "curtainRunningUp: eclipse!");
-        return;
-    }
-
-    if(curtainState == CurtainState::STOP) {
-        curtainState = CurtainState::RUNNING_UP;
-    } else {
-        curtainState = CurtainState::STOP;
-    }
+    post(Command::CURTAIN_UP);
 }
 
 void EclipseControl::curtainRunningDown() {
-    syslog(LOG_INFO, "curtainRunningDown");
-    if(eclipsed) {
-        syslog(LOG_WARNING, "curtainRunningDown: eclipse!");
-        return;
+    post(Command::CURTAIN_DOWN);
+}
+
+void EclipseControl::applyScene(std::optional<bool> curtainDown, std::optional<bool> lightOn) {
+    std::uint8_t arg = 0;
+    if(curtainDown) {
+        arg |= SCENE_CURTAIN | (*curtainDown ? SCENE_CURTAIN_DOWN : 0);
     }
+    if(lightOn) {
+        arg |= SCENE_LIGHT | (*lightOn ? SCENE_LIGHT_ON : 0);
+    }
+    post(Command::SCENE, arg);
+}
 
-    if(curtainState == CurtainState::STOP) {
-        curtainState = CurtainState::RUNNING_DOWN;
-    } else {
-        curtainState = CurtainState::STOP;
+void EclipseControl::post(Command command, std::uint8_t arg) {
+    if(!commands.send(Posted{command, arg, toNs(clock->now())})) {
+        syslog(LOG_ERR, "eclipse control: command queue full, command <%d> dropped", static_cast<int>(command));
     }
 }
 
-void EclipseControl::curtainControl() {
+Task EclipseControl::receiveCommands() {
+    while(true) {
+        handle(co_await message(commands));
+    }
+}
 
-    while(running) {
-        std::this_thread::sleep_for(std::chrono::milliseconds{500});
+void EclipseControl::handle(const Posted &posted) {
+    auto latency = clock->now() - Clock::TimePoint{std::chrono::nanoseconds{posted.postedAt}};
+    lightRamp = lightFade;
 
-        int x;
+    switch(posted.command) {
+        case Command::CURTAIN_UP:
+            fireCurtain(CurtainEvent::UP, latency);
+            break;
 
-        switch(curtainState) {
-            case CurtainState::STOP:
-                continue;
+        case Command::CURTAIN_DOWN:
+            fireCurtain(CurtainEvent::DOWN, latency);
+            break;
 
-            case CurtainState::POS_UP:
-                x = 120 - curtainPos;
+        case Command::ECLIPSE_START: {
+            auto state = curtain.state();
+            if(state == CurtainState::ECLIPSE_CLOSING || state == CurtainState::ECLIPSED) {
+                syslog(LOG_WARNING, "startEclipse: allready eclipsed!");
                 break;
+            }
+            // still opening: the light has not been restored yet, keep what was saved
+            if(state != CurtainState::ECLIPSE_OPENING) {
+                mainLightWasOn = isLightOn();
+            }
+            if(mainLightWasOn) {
+                lightTarget = LightTarget::OFF;
+                lightRamp = duskRamp;
+            }
+            fireCurtain(CurtainEvent::ECLIPSE_START, latency);
+            break;
+        }
 
-            case CurtainState::RUNNING_UP:
-                x = curtainPos;
-                break;
+        case Command::ECLIPSE_STOP:
+            if(fireCurtain(CurtainEvent::ECLIPSE_STOP, latency) && mainLightWasOn) {
+                lightTarget = LightTarget::ON;
+                lightRamp = dawnRamp;
+            }
+            break;
+
+        case Command::LIGHT_ON:
+            syslog(LOG_INFO, "mainLightOn");
+            lightTarget = LightTarget::ON;
+            break;
+
+        case Command::LIGHT_OFF:
+            syslog(LOG_INFO, "mainLightOff");
+            lightTarget = LightTarget::OFF;
+            break;
+
+        case Command::SCENE:
+            if(posted.arg & SCENE_CURTAIN) {
+                bool down = posted.arg & SCENE_CURTAIN_DOWN;
+                // already there, no need for a transition to END_REACHED
+                if(curtain.state() != CurtainState::IDLE || curtainPos != (down ? CURTAIN_POS_MAX : 0)) {
+                    fireCurtain(down ? CurtainEvent::TO_DOWN : CurtainEvent::TO_UP, latency);
+                }
+            }
+            if(posted.arg & SCENE_LIGHT) {
+                lightTarget = posted.arg & SCENE_LIGHT_ON ? LightTarget::ON : LightTarget::OFF;
+            }
+            break;
+    }
+    if(lightTarget != LightTarget::NONE) {
+        switchLight();
+    }
+}
 
-            case CurtainState::POS_DOWN:
-                x = 130 - curtainPos;
-                bridge->setHigh(Bridge::CURTAIN_DIR);
-                break;
+// fired by the tasks themselves, so they must be legal in every state they are fired in
+static_assert(EclipseControl::CURTAIN_TABLE.accepts(CS::RUNNING_UP, CE::END_REACHED));
+static_assert(EclipseControl::CURTAIN_TABLE.accepts(CS::RUNNING_DOWN, CE::END_REACHED));
+static_assert(EclipseControl::CURTAIN_TABLE.accepts(CS::ECLIPSE_CLOSING, CE::END_REACHED));
+static_assert(EclipseControl::CURTAIN_TABLE.accepts(CS::ECLIPSE_OPENING, CE::END_REACHED));
+static_assert(EclipseControl::LIGHT_TABLE.accepts(EclipseControl::LightState::IDLE, EclipseControl::LightEvent::SWITCH));
+static_assert(EclipseControl::LIGHT_TABLE.accepts(EclipseControl::LightState::PULSING, EclipseControl::LightEvent::PULSE_DONE));
+static_assert(EclipseControl::LIGHT_TABLE.accepts(EclipseControl::LightState::CONFIRMING, EclipseControl::LightEvent::CONFIRMED));
+static_assert(EclipseControl::LIGHT_TABLE.accepts(EclipseControl::LightState::CONFIRMING, EclipseControl::LightEvent::TIMEOUT));
+
+// a scene never stops a running curtain
+static_assert(EclipseControl::CURTAIN_TABLE.accepts(CS::RUNNING_UP, CE::TO_UP));
+static_assert(EclipseControl::CURTAIN_TABLE.accepts(CS::RUNNING_DOWN, CE::TO_DOWN));
+
+// no manual curtain control during an eclipse, no scene either
+static_assert(!EclipseControl::CURTAIN_TABLE.accepts(CS::ECLIPSED, CE::UP));
+static_assert(!EclipseControl::CURTAIN_TABLE.accepts(CS::ECLIPSE_CLOSING, CE::DOWN));
+static_assert(!EclipseControl::CURTAIN_TABLE.accepts(CS::ECLIPSED, CE::TO_UP));
+
+bool EclipseControl::fireCurtain(CurtainEvent event, Clock::Duration latency) {
+    CurtainState from, to;
+    bool accepted = curtain.fire(event, from, to);
+    record(TransitionRecord{
+        clock->now(), "curtain", toString(from), toString(event), toString(accepted ? to : from), accepted, latency
+    });
+    if(accepted) {
+        enterCurtain(from, to);
+    }
+    return accepted;
+}
 
-            case CurtainState::RUNNING_DOWN:
-                x = curtainPos;
-                bridge->setHigh(Bridge::CURTAIN_DIR);
-                break;
-        }
+bool EclipseControl::fireLight(LightEvent event, Clock::Duration latency) {
+    LightState from, to;
+    bool accepted = light.fire(event, from, to);
+    record(TransitionRecord{
+        clock->now(), "light", toString(from), toString(event), toString(accepted ? to : from), accepted, latency
+    });
+    return accepted;
+}
 
-        bridge->setHigh(Bridge::CURTAIN_ON);
+void EclipseControl::enterCurtain(CurtainState from, CurtainState to) {
+    if(!isRunning(to)) {
+        // may be the task firing END_REACHED, it is destroyed once it returns
+        curtainTask.cancel();
+        syslog(LOG_INFO, "curtain stopped at <%d>", curtainPos.load());
+        return;
+    }
 
-        do {
-            if(curtainState == CurtainState::STOP) {
-                break;
-            }
-            std::this_thread::sleep_for(std::chrono::milliseconds{250});
-        } while(true);
+    bool down = isDown(to);
+    if(curtainPos == (down ? CURTAIN_POS_MAX : 0)) {
+        fireCurtain(CurtainEvent::END_REACHED);
+        return;
+    }
+    if(isRunning(from) && isDown(from) == down) {
+        // e.g. eclipse taking over a curtain already running down
+        return;
+    }
+    // reversing cancels the running task, its guard stops the motor before the new task runs
+    curtainTask = runCurtain(down, isRunning(from));
+    loop.spawn(curtainTask);
+}
 
+Task EclipseControl::runCurtain(bool down, bool reversing) {
+    constexpr auto motor = Bridge::mask(Bridge::CURTAIN_ON) | Bridge::mask(Bridge::CURTAIN_DIR);
 
+    struct MotorGuard {
+        Bridge &bridge;
 
+        ~MotorGuard() {
+            bridge.setMask(0, motor);
+        }
+    } guard{*bridge};
 
+    auto tick = clock->now();
+    if(reversing) {
+        tick += CURTAIN_TICK;
+        co_await delayUntil(tick);
+    }
+    bridge->setMask(down ? motor : Bridge::mask(Bridge::CURTAIN_ON), down ? 0 : Bridge::mask(Bridge::CURTAIN_DIR));
+
+    while(curtainPos != (down ? CURTAIN_POS_MAX : 0)) {
+        tick += CURTAIN_TICK;
+        co_await delayUntil(tick);
+        curtainPos += down ? 1 : -1;
+        if(telemetry) {
+            telemetry->record(Telemetry::Kind::CURTAIN_POS, 0, curtainPos);
+        }
+    }
+    fireCurtain(CurtainEvent::END_REACHED);
+}
 
+void EclipseControl::switchLight() {
+    if(dimmer) {
+        dimLight(std::exchange(lightTarget, LightTarget::NONE) == LightTarget::ON, lightRamp);
+        return;
+    }
+    // a running task picks up the new target after its pulse
+    if(lightTask.done()) {
+        lightTask = controlLight();
+        loop.spawn(lightTask);
+    }
+}
 
-        for(int i = 0; i < 120; ++i) {
+Task EclipseControl::controlLight() {
+    struct RelayGuard {
+        Bridge &bridge;
+
+        ~RelayGuard() {
+            bridge.setLow(Bridge::MAIN_LIGHT);
         }
+    } guard{*bridge};
 
-    auto currentCurtainState = ;
+    while(lightTarget != LightTarget::NONE) {
+        bool on = std::exchange(lightTarget, LightTarget::NONE) == LightTarget::ON;
 
+        for(int attempt = 0; on != isLightOn(); ++attempt) {
+            if(attempt > lightRetries) {
+                syslog(LOG_ERR, "main light did not switch %s, gave up after %d attempts", on ? "on" : "off", attempt);
+                std::lock_guard<std::mutex> l{lightStatsMutex};
+                ++lightStats.failures;
+                break;
+            }
+            if(attempt) {
+                co_await delay(lightBackoff * (1 << (attempt - 1)));
+                if(lightTarget != LightTarget::NONE) {
+                    break;
+                }
+                // a lagging feedback contact may have caught up meanwhile, another pulse would toggle back
+                if(on == isLightOn()) {
+                    break;
+                }
+                std::lock_guard<std::mutex> l{lightStatsMutex};
+                ++lightStats.retries;
+            }
 
-          /*
-        STOP         = 0,
-        POS_UP       = 1,
-        POS_DOWN     = 2,
-        RUNNING_UP   = 3,
-        RUNNING_DOWN = 4,
-     */
+            auto start = clock->now();
+            fireLight(LightEvent::SWITCH);
+            bridge->setHigh(Bridge::MAIN_LIGHT);
+
+            // LIGHT_STATE is active low; the pulse ends as soon as the relay switched, a retry
+            // pulses longer in case the relay got slower than learned
+            auto pulse = std::min<Clock::Duration>(lightPulse() * (1 << attempt), MAX_PULSE);
+            bool confirmed = co_await pinEdge(bridge, Bridge::LIGHT_STATE, !on, pulse);
+            auto response = clock->now() - start;
+            co_await delayUntil(start + MIN_PULSE);
+            fireLight(LightEvent::PULSE_DONE);
+            bridge->setLow(Bridge::MAIN_LIGHT);
+
+            if(!confirmed) {
+                // the feedback contact may lag behind the relay
+                confirmed = co_await pinEdge(bridge, Bridge::LIGHT_STATE, !on, lightTimeout);
+                response = clock->now() - start;
+            }
+            fireLight(confirmed ? LightEvent::CONFIRMED : LightEvent::TIMEOUT);
+            if(confirmed) {
+                learnResponse(response);
+            } else {
+                syslog(LOG_WARNING, "main light did not switch %s within %lld ms", on ? "on" : "off", static_cast<long long>(
+                    std::chrono::duration_cast<std::chrono::milliseconds>(clock->now() - start).count()
+                ));
+            }
+        }
+    }
+}
 
+void EclipseControl::dimLight(bool on, Clock::Duration ramp) {
+    auto now = clock->now();
+    auto from = dimmerPattern.brightnessAt(now - dimmerStart);
+    std::uint16_t to = on ? lightBrightness : 0;
+    if(from == to && dimmerPattern.settled() == to) {
+        return;
+    }
+    auto duration = lightBrightness ? ramp * std::abs(to - from) / lightBrightness : Clock::Duration::zero();
+    dimmerPattern = PwmPattern::ramp(from, to, duration);
+    dimmerStart = now;
+    bridge->playPwm(Bridge::MAIN_LIGHT, dimmerPattern);
+    syslog(LOG_INFO, "main light dimmed from <%u> to <%u> within <%lld> ms", from, to, static_cast<long long>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(duration).count()
+    ));
+
+    std::lock_guard<std::mutex> l{lightStatsMutex};
+    ++lightStats.switches;
+}
 
+Clock::Duration EclipseControl::lightPulse() {
+    std::lock_guard<std::mutex> l{lightStatsMutex};
+    return lightStats.pulse;
+}
 
+Clock::Duration EclipseControl::pulseFor(Clock::Duration response) {
+    if(response == Clock::Duration::zero()) {
+        return MAX_PULSE;
+    }
+    return std::clamp<Clock::Duration>(2 * response + EventLoop::PIN_POLL, MIN_PULSE, MAX_PULSE);
+}
 
+void EclipseControl::learnResponse(Clock::Duration response) {
+    std::lock_guard<std::mutex> l{lightStatsMutex};
+    ++lightStats.switches;
+    // includes up to one pin poll of detection delay, smoothed over about four switches
+    auto &r = lightStats.response;
+    r = r == Clock::Duration::zero() ? response : (3 * r + response) / 4;
+    lightStats.pulse = pulseFor(r);
+}
 
-        bridge->setLow(Bridge::CURTAIN_ON);
-        bridge->setLow(Bridge::CURTAIN_DIR);
+bool EclipseControl::isLightOn() {
+    if(dimmer) {
+        return dimmerPattern.settled() > 0;
     }
+    // LIGHT_STATE is active low
+    return !bridge->getDebounced(Bridge::LIGHT_STATE);
 }
 
-void EclipseControl::mainLightControl() {
-    while(running) {
-        std::this_thread::sleep_for(std::chrono::milliseconds{500});
-        MainLightState mal = mainLightState;
-
-        if(mal == MainLightState::IDLE) {
-            continue;
-        }
-        if(!bridge->getDebounced(Bridge::LIGHT_STATE) && mal == MainLightState::ON) {
-            continue;
-        }
-        if(bridge->getDebounced(Bridge::LIGHT_STATE) && mal == MainLightState::OFF) {
-            continue;
-        }
-        bridge->setHight(Bridge::MAIN_LIGHT);
-        std::this_thread::sleep_for(std::chrono::milliseconds{500});
-        bridge->setLow(Bridge::MAIN_LIGHT);
-        mainLightState = MainLightState::IDLE;
+void EclipseControl::record(const TransitionRecord &rec) {
+    if(rec.accepted) {
+        syslog(LOG_INFO, "%s: %s -%s-> %s", rec.machine, rec.from, rec.event, rec.to);
+    } else {
+        syslog(LOG_WARNING, "%s: event <%s> rejected in state <%s>", rec.machine, rec.event, rec.from);
+    }
+    std::lock_guard<std::mutex> l{observerMutex};
+    if(observer) {
+        observer(rec);
     }
 }
@@ -21,13 +21,145 @@
 #pragma once
 
 #include "bridge.h"
+#include "clock.h"
+#include "eventloop.h"
+#include "statemachine.h"
+#include "telemetry.h"
+#include "watchdog.h"
 #include <moba-common/ini.h>
 #include <atomic>
-#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
 
+/**
+ * Curtain and main light as two table driven state machines, owned by one
+ * event loop. The public methods only post a command into a mailbox, which
+ * wakes the loop at once. Entering a running curtain state starts a curtain
+ * task, a switch request starts a light task; a newer command cancels a
+ * running curtain task, its motor guard switches the motor off on the spot.
+ * All state, e.g. whether the light was on before an eclipse, lives in the
+ * loop thread.
+ *
+ * The main light is switched closed loop: the relay pulse ends as soon as
+ * LIGHT_STATE follows, a switch that is not confirmed within the timeout is
+ * retried with growing backoff. The pulse is sized from the measured relay
+ * response time, which is kept in the state file. Section [light]:
+ *   timeout=<ms>   LIGHT_STATE may lag behind the end of a pulse
+ *   retries=<n>
+ *   backoff=<ms>   before the first retry, doubled for every further one
+ *   response=<ms>  measured, 0 -> not known yet
+ *
+ * With driver=dimmer MAIN_LIGHT drives a PWM dimmer instead of the relay. A
+ * switch is a ramp played by the backend: down over dusk when an eclipse
+ * starts, up over dawn when it is over, over fade otherwise. There is no
+ * feedback then, the light state machine stays IDLE.
+ *   driver=relay|dimmer
+ *   brightness=<permille>   of the light switched on
+ *   fade=<ms>  dusk=<ms>  dawn=<ms>
+ */
 class EclipseControl final {
 public:
-    EclipseControl(BridgePtr bridge, moba::IniPtr ini);
+    enum class CurtainState: std::uint8_t {
+        IDLE            = 0,
+        RUNNING_UP      = 1,
+        RUNNING_DOWN    = 2,
+        ECLIPSE_CLOSING = 3,
+        ECLIPSED        = 4,
+        ECLIPSE_OPENING = 5,
+    };
+
+    enum class CurtainEvent: std::uint8_t {
+        UP            = 0,  // button like: starts or stops
+        DOWN          = 1,
+        ECLIPSE_START = 2,
+        ECLIPSE_STOP  = 3,
+        END_REACHED   = 4,
+        TO_UP         = 5,  // scene like: runs to the end stop unless it already does
+        TO_DOWN       = 6,
+    };
+
+    enum class LightState: std::uint8_t {
+        IDLE       = 0,
+        PULSING    = 1,  // impulse relay closed
+        CONFIRMING = 2,  // relay open again, LIGHT_STATE has not followed yet
+    };
+
+    enum class LightEvent: std::uint8_t {
+        SWITCH     = 0,
+        PULSE_DONE = 1,
+        CONFIRMED  = 2,  // LIGHT_STATE followed
+        TIMEOUT    = 3,
+    };
+
+    struct LightStats {
+        std::uint64_t switches;
+        std::uint64_t retries;
+        // given up after all retries
+        std::uint64_t failures;
+        // smoothed, zero if not known yet
+        Clock::Duration response;
+        Clock::Duration pulse;
+    };
+
+    using CS = CurtainState;
+    using CE = CurtainEvent;
+
+    static constexpr TransitionTable<CurtainState, CurtainEvent, 22> CURTAIN_TABLE{{
+        {CS::IDLE,            CE::UP,            CS::RUNNING_UP},
+        {CS::IDLE,            CE::DOWN,          CS::RUNNING_DOWN},
+        {CS::RUNNING_UP,      CE::UP,            CS::IDLE},
+        {CS::RUNNING_UP,      CE::DOWN,          CS::IDLE},
+        {CS::RUNNING_UP,      CE::END_REACHED,   CS::IDLE},
+        {CS::RUNNING_DOWN,    CE::UP,            CS::IDLE},
+        {CS::RUNNING_DOWN,    CE::DOWN,          CS::IDLE},
+        {CS::RUNNING_DOWN,    CE::END_REACHED,   CS::IDLE},
+        {CS::IDLE,            CE::TO_UP,         CS::RUNNING_UP},
+        {CS::IDLE,            CE::TO_DOWN,       CS::RUNNING_DOWN},
+        {CS::RUNNING_UP,      CE::TO_UP,         CS::RUNNING_UP},
+        {CS::RUNNING_UP,      CE::TO_DOWN,       CS::RUNNING_DOWN},
+        {CS::RUNNING_DOWN,    CE::TO_UP,         CS::RUNNING_UP},
+        {CS::RUNNING_DOWN,    CE::TO_DOWN,       CS::RUNNING_DOWN},
+        // the eclipse overrides manual control, buttons are rejected until it is over
+        {CS::IDLE,            CE::ECLIPSE_START, CS::ECLIPSE_CLOSING},
+        {CS::RUNNING_UP,      CE::ECLIPSE_START, CS::ECLIPSE_CLOSING},
+        {CS::RUNNING_DOWN,    CE::ECLIPSE_START, CS::ECLIPSE_CLOSING},
+        {CS::ECLIPSE_CLOSING, CE::END_REACHED,   CS::ECLIPSED},
+        {CS::ECLIPSE_CLOSING, CE::ECLIPSE_STOP,  CS::ECLIPSE_OPENING},
+        {CS::ECLIPSED,        CE::ECLIPSE_STOP,  CS::ECLIPSE_OPENING},
+        {CS::ECLIPSE_OPENING, CE::ECLIPSE_START, CS::ECLIPSE_CLOSING},
+        {CS::ECLIPSE_OPENING, CE::END_REACHED,   CS::IDLE},
+    }};
+
+    static constexpr TransitionTable<LightState, LightEvent, 4> LIGHT_TABLE{{
+        {LightState::IDLE,       LightEvent::SWITCH,     LightState::PULSING},
+        {LightState::PULSING,    LightEvent::PULSE_DONE, LightState::CONFIRMING},
+        {LightState::CONFIRMING, LightEvent::CONFIRMED,  LightState::IDLE},
+        {LightState::CONFIRMING, LightEvent::TIMEOUT,    LightState::IDLE},
+    }};
+
+    struct TransitionRecord {
+        Clock::TimePoint time;
+        const char *machine;
+        const char *from;
+        const char *event;
+        const char *to;
+        bool accepted;
+        // from posting the command until the transition
+        Clock::Duration latency;
+    };
+
+    using TransitionObserver = std::function<void(const TransitionRecord&)>;
+
+    /**
+     * telemetry may be null, otherwise every curtain step is recorded
+     */
+    EclipseControl(
+        BridgePtr bridge, moba::IniPtr ini, ClockPtr clock, WatchdogPtr watchdog, TelemetryPtr telemetry
+    );
 
     EclipseControl(const EclipseControl&) = delete;
     EclipseControl& operator=(const EclipseControl&) = delete;
@@ -43,36 +175,160 @@ public:
     void curtainRunningUp();
     void curtainRunningDown();
 
+    /**
+     * Curtain and main light targets of a scene, both handled in one loop
+     * iteration. An empty target leaves that output alone.
+     */
+    void applyScene(std::optional<bool> curtainDown, std::optional<bool> lightOn);
+
+    /**
+     * Stops and joins the loop thread. A running curtain is stopped, a main
+     * light impulse in progress is cut short.
+     */
+    void stop();
+
+    /**
+     * Writes the curtain position and the relay response time to the state
+     * file.
+     */
+    void saveState();
+
+    CurtainState getCurtainState() const {
+        return curtain.state();
+    }
+
+    LightState getLightState() const {
+        return light.state();
+    }
+
+    /**
+     * From any thread.
+     */
+    LightStats getLightStats();
+
+    /**
+     * Called in the loop thread on every transition, also on rejected ones.
+     */
+    void setTransitionObserver(TransitionObserver observer);
+
 private:
-    enum class CurtainState {
-        STOP         = 0,
-        POS_UP       = 1,
-        POS_DOWN     = 2,
-        RUNNING_UP   = 3,
-        RUNNING_DOWN = 4,
+    enum class Command: std::uint8_t {
+        CURTAIN_UP    = 0,
+        CURTAIN_DOWN  = 1,
+        ECLIPSE_START = 2,
+        ECLIPSE_STOP  = 3,
+        LIGHT_ON      = 4,
+        LIGHT_OFF     = 5,
+        SCENE         = 6,
     };
 
-    enum class MainLightState {
-        ON   = 0,
-        OFF  = 1,
-        IDLE = 2,
+    // Posted::arg of a SCENE
+    static constexpr std::uint8_t SCENE_CURTAIN      = 1;
+    static constexpr std::uint8_t SCENE_CURTAIN_DOWN = 2;
+    static constexpr std::uint8_t SCENE_LIGHT        = 4;
+    static constexpr std::uint8_t SCENE_LIGHT_ON     = 8;
+
+    struct Posted {
+        Command command;
+        std::uint8_t arg;
+        // ns since clock epoch
+        std::int64_t postedAt;
     };
 
-    void curtainControl();
-    void mainLightControl();
+    enum class LightTarget: std::uint8_t {
+        NONE = 0,
+        ON   = 1,
+        OFF  = 2,
+    };
+
+    // curtain position runs from 0 (up) to CURTAIN_POS_MAX (down), one step per CURTAIN_TICK
+    static constexpr int CURTAIN_POS_MAX = 120;
+    static constexpr std::chrono::milliseconds CURTAIN_TICK{250};
+    // the relay is closed at least MIN_PULSE and at most MAX_PULSE, see pulseFor()
+    static constexpr std::chrono::milliseconds MIN_PULSE{20};
+    static constexpr std::chrono::milliseconds MAX_PULSE{500};
+
+    void post(Command command, std::uint8_t arg = 0);
+    Task receiveCommands();
+    void handle(const Posted &posted);
+
+    /**
+     * @return false if the event was rejected
+     */
+    bool fireCurtain(CurtainEvent event, Clock::Duration latency = Clock::Duration::zero());
+    bool fireLight(LightEvent event, Clock::Duration latency = Clock::Duration::zero());
+    void enterCurtain(CurtainState from, CurtainState to);
+    void switchLight();
+
+    /**
+     * Runs the curtain to its end stop, one step per CURTAIN_TICK.
+     * @param reversing the motor pauses for one tick before it changes direction
+     */
+    Task runCurtain(bool down, bool reversing);
+
+    /**
+     * Pulses the impulse relay until the light matches the last target, a
+     * newer target takes over between two attempts.
+     */
+    Task controlLight();
+
+    Clock::Duration lightPulse();
+
+    /**
+     * Ramps the dimmer from where it is now to on or off, a ramp taken over
+     * halfway keeps its pace.
+     */
+    void dimLight(bool on, Clock::Duration ramp);
+
+    /**
+     * Twice the response time plus one pin poll, all of MAX_PULSE as long
+     * as the response time is not known.
+     */
+    static Clock::Duration pulseFor(Clock::Duration response);
+    void learnResponse(Clock::Duration response);
+    void record(const TransitionRecord &rec);
+
+    bool isLightOn();
 
     BridgePtr bridge;
     moba::IniPtr ini;
+    ClockPtr clock;
+    TelemetryPtr telemetry;
 
-    std::thread curtainThread;
-    std::thread mainLightThread;
+    StateMachine<CurtainState, CurtainEvent, 22> curtain{CURTAIN_TABLE, CurtainState::IDLE};
+    StateMachine<LightState, LightEvent, 4> light{LIGHT_TABLE, LightState::IDLE};
+
+    std::mutex observerMutex;
+    TransitionObserver observer;
 
-    std::atomic<bool> running{true};
     std::atomic<int> curtainPos;
-    std::atomic<CurtainState> curtainState{CurtainState::STOP};
-    std::atomic<MainLightState> mainLightState{MainLightState::IDLE};
 
-    bool eclipsed{false};
+    Clock::Duration lightTimeout;
+    int lightRetries;
+    Clock::Duration lightBackoff;
+
+    bool dimmer{false};
+    std::uint16_t lightBrightness{PwmPattern::FULL};
+    Clock::Duration lightFade;
+    Clock::Duration duskRamp;
+    Clock::Duration dawnRamp;
+
+    std::mutex lightStatsMutex;
+    LightStats lightStats{0, 0, 0, Clock::Duration::zero(), Clock::Duration::zero()};
+
+    EventLoop loop;
+    Mailbox<Posted> commands{loop};
+
+    // loop thread only; declared after the loop, so the tasks go first and deregister their timers
+    Task dispatcher;
+    Task curtainTask;
+    Task lightTask;
+    LightTarget lightTarget{LightTarget::NONE};
     bool mainLightWasOn{false};
+    // dimmer only: the ramp for lightTarget, the pattern playing
+    Clock::Duration lightRamp{};
+    PwmPattern dimmerPattern;
+    Clock::TimePoint dimmerStart{};
 };
 
+using EclipseControlPtr = std::shared_ptr<EclipseControl>;
@@ -0,0 +1,244 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "eventloop.h"
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <syslog.h>
+
+#include "blockpool.h"
+#include "heapguard.h"
+
+namespace {
+    // upper bound for a sleep, keeps the heartbeat going while nothing happens
+    constexpr std::chrono::milliseconds IDLE_WAKE{250};
+
+    // enough for the tasks of the eclipse control, which never run more than one of a kind
+    constexpr std::size_t TIMERS = 16;
+    constexpr std::size_t WATCHES = 8;
+    constexpr std::size_t TASKS = 16;
+
+    constexpr std::size_t FRAMES = 16;
+    constexpr std::size_t FRAME_SIZE = 1024;
+
+    std::once_flag framePoolInit;
+    std::unique_ptr<BlockPool> framePool;
+
+    BlockPool &frames() {
+        std::call_once(framePoolInit, []{framePool = std::make_unique<BlockPool>(FRAMES, FRAME_SIZE);});
+        return *framePool;
+    }
+}
+
+thread_local EventLoop *EventLoop::running = nullptr;
+
+void Task::promise_type::unhandled_exception() {
+    try {
+        throw;
+    } catch(const std::exception &e) {
+        syslog(LOG_ERR, "task failed: <%s>", e.what());
+    } catch(...) {
+        syslog(LOG_ERR, "task failed");
+    }
+}
+
+void *Task::promise_type::operator new(std::size_t size) {
+    return frames().allocate(size);
+}
+
+void Task::promise_type::operator delete(void *p) noexcept {
+    frames().deallocate(p);
+}
+
+void Task::reserveFrames(std::size_t count, std::size_t size) {
+    bool applied = false;
+    std::call_once(framePoolInit, [&] {
+        framePool = std::make_unique<BlockPool>(count, size);
+        applied = true;
+    });
+    if(!applied) {
+        syslog(LOG_WARNING, "reserveFrames: frame pool already set up");
+    }
+}
+
+std::size_t Task::frameOverflows() {
+    return frames().getOverflows();
+}
+
+Task& Task::operator=(Task &&other) noexcept {
+    if(this != &other) {
+        cancel();
+        handle = std::exchange(other.handle, {});
+    }
+    return *this;
+}
+
+void Task::cancel() {
+    if(!handle) {
+        return;
+    }
+    auto h = std::exchange(handle, {});
+    if(auto loop = EventLoop::current()) {
+        loop->retire(h);
+    } else {
+        h.destroy();
+    }
+}
+
+EventLoop::EventLoop(ClockPtr clock, Watchdog::HeartbeatPtr heartbeat):
+clock{std::move(clock)}, heartbeat{std::move(heartbeat)} {
+    // no allocations while running, as long as these suffice
+    ready.reserve(TASKS);
+    graveyard.reserve(TASKS);
+    timers.reserve(TIMERS);
+    watches.reserve(WATCHES);
+    dueWatches.reserve(WATCHES);
+}
+
+EventLoop::~EventLoop() noexcept {
+    stop();
+}
+
+void EventLoop::start() {
+    loopThread = clock->startThread([this]{run();});
+}
+
+void EventLoop::stop() {
+    active = false;
+    wake();
+    if(loopThread.joinable()) {
+        loopThread.join();
+    }
+}
+
+void EventLoop::spawn(Task &task) {
+    if(!task.done()) {
+        ready.push_back(task.handle);
+    }
+}
+
+void EventLoop::run() {
+    HeapGuard::guardThread();
+    running = this;
+    while(active) {
+        heartbeat->beat();
+
+        // until nothing is left to do at this point of time
+        while(runDue()) {
+        }
+
+        auto now = clock->now();
+        auto wakeUp = now + IDLE_WAKE;
+        if(!timers.empty()) {
+            wakeUp = std::min(wakeUp, timers.front()->at);
+        }
+        if(!watches.empty()) {
+            wakeUp = std::min(wakeUp, nextPinPoll);
+        }
+        if(wakeUp > now) {
+            clock->sleepFor(wakeUp - now, alarm);
+        }
+    }
+    heartbeat->pause();
+    running = nullptr;
+}
+
+bool EventLoop::runDue() {
+    bool progress = false;
+
+    while(!ready.empty()) {
+        auto h = ready.front();
+        ready.erase(ready.begin());
+        resume(h);
+        progress = true;
+    }
+
+    for(std::size_t i = 0; i < mailboxes.size(); ++i) {
+        while(mailboxes[i]->dispatch()) {
+            progress = true;
+        }
+    }
+
+    auto now = clock->now();
+    while(!timers.empty() && timers.front()->at <= now) {
+        auto timer = timers.front();
+        timers.erase(timers.begin());
+        timer->pending = false;
+        resume(timer->handle);
+        progress = true;
+    }
+
+    return pollPins(now) || progress;
+}
+
+bool EventLoop::pollPins(Clock::TimePoint now) {
+    if(watches.empty() || now < nextPinPoll) {
+        return false;
+    }
+    nextPinPoll = now + PIN_POLL;
+
+    // a resumed task may add or remove watches, so pick them first
+    dueWatches.clear();
+    for(auto watch: watches) {
+        watch->reached = watch->sample(now);
+        if(watch->reached || now >= watch->deadline) {
+            dueWatches.push_back(watch);
+        }
+    }
+    for(std::size_t i = 0; i < dueWatches.size(); ++i) {
+        auto watch = dueWatches[i];
+        // gone if an earlier one cancelled its task
+        if(std::find(watches.begin(), watches.end(), watch) == watches.end()) {
+            continue;
+        }
+        std::erase(watches, watch);
+        watch->pending = false;
+        resume(watch->handle);
+    }
+    return !dueWatches.empty();
+}
+
+void EventLoop::resume(std::coroutine_handle<> h) {
+    h.resume();
+    while(!graveyard.empty()) {
+        // destroying a frame may cancel nested tasks, they land here as well
+        auto dead = graveyard.back();
+        graveyard.pop_back();
+        dead.destroy();
+    }
+}
+
+void EventLoop::addTimer(Timer *timer) {
+    // ordered by time, same times in order of arrival
+    auto pos = std::upper_bound(timers.begin(), timers.end(), timer->at, [](Clock::TimePoint at, const Timer *t) {
+        return at < t->at;
+    });
+    timers.insert(pos, timer);
+}
+
+void EventLoop::retire(std::coroutine_handle<> h) {
+    // it might be the running one, so it is destroyed only after the resume
+    std::erase(ready, h);
+    graveyard.push_back(h);
+}
@@ -0,0 +1,480 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include "bridge.h"
+#include "clock.h"
+#include "mpscring.h"
+#include "watchdog.h"
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class EventLoop;
+
+/**
+ * A coroutine running on an EventLoop. It starts suspended, EventLoop::spawn()
+ * schedules it. Destroying or reassigning the Task cancels it: the frame is
+ * destroyed, so destructors of its locals run (e.g. a guard switching the
+ * motor off). A task may cancel itself, the frame then goes away as soon as
+ * it suspends or returns.
+ *
+ * A Task can be co_awaited by another one, it then runs as part of the
+ * awaiting task and is cancelled with it.
+ */
+class Task final {
+public:
+    struct promise_type {
+        // the awaiting task, if nested
+        std::coroutine_handle<> continuation;
+        bool done{false};
+
+        Task get_return_object() {
+            return Task{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+
+        auto final_suspend() noexcept {
+            struct Final {
+                bool await_ready() noexcept {
+                    return false;
+                }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                    h.promise().done = true;
+                    if(h.promise().continuation) {
+                        return h.promise().continuation;
+                    }
+                    return std::noop_coroutine();
+                }
+
+                void await_resume() noexcept {
+                }
+            };
+            return Final{};
+        }
+
+        void return_void() {
+        }
+
+        void unhandled_exception();
+
+        // frames come from a pool, see reserveFrames()
+        static void *operator new(std::size_t size);
+        static void operator delete(void *p) noexcept;
+    };
+
+    /**
+     * Sets up the frame pool: count frames of up to size bytes. Only before
+     * the first task, later calls are ignored. By default 16 x 1024 bytes.
+     */
+    static void reserveFrames(std::size_t count, std::size_t size);
+
+    /**
+     * Frames that did not fit into the pool and came from the heap.
+     */
+    static std::size_t frameOverflows();
+
+    Task() = default;
+
+    Task(Task &&other) noexcept: handle{std::exchange(other.handle, {})} {
+    }
+
+    Task& operator=(Task &&other) noexcept;
+
+    ~Task() {
+        cancel();
+    }
+
+    /**
+     * True if the task returned, was cancelled or never existed.
+     */
+    bool done() const {
+        return !handle || handle.promise().done;
+    }
+
+    void cancel();
+
+    bool await_ready() const noexcept {
+        return done();
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+
+    void await_resume() const noexcept {
+    }
+
+private:
+    friend class EventLoop;
+
+    explicit Task(std::coroutine_handle<promise_type> handle): handle{handle} {
+    }
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+/**
+ * Runs tasks on a single thread. A task runs until it suspends in one of the
+ * awaitables below, the loop then sleeps until the next timer, the next pin
+ * poll or a message, whichever comes first. A message wakes the loop at once.
+ *
+ * Tasks are spawned, resumed and cancelled on the loop thread only (or before
+ * start() / after stop()); only Mailbox::send() may be called from any thread.
+ */
+class EventLoop final {
+public:
+    // how often inputs are read while a task waits for a pin edge
+    static constexpr std::chrono::milliseconds PIN_POLL{10};
+
+    EventLoop(ClockPtr clock, Watchdog::HeartbeatPtr heartbeat);
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    ~EventLoop() noexcept;
+
+    void start();
+
+    /**
+     * Stops and joins the loop thread, suspended tasks stay suspended until
+     * their owners destroy them.
+     */
+    void stop();
+
+    /**
+     * Schedules the first run of task, it runs within the current iteration.
+     */
+    void spawn(Task &task);
+
+    /**
+     * The loop of the calling thread, null outside of a task.
+     */
+    static EventLoop *current() {
+        return running;
+    }
+
+    ClockPtr getClock() const {
+        return clock;
+    }
+
+    /**
+     * Wakes the loop from any thread.
+     */
+    void wake() {
+        clock->wake(alarm);
+    }
+
+    class Timer;
+    class PinWatch;
+    class MailboxBase;
+
+private:
+    friend class Task;
+    friend class Timer;
+    friend class PinWatch;
+    friend class MailboxBase;
+
+    void run();
+
+    /**
+     * Resumes h and then destroys the frames cancelled meanwhile.
+     */
+    void resume(std::coroutine_handle<> h);
+    void retire(std::coroutine_handle<> h);
+    void addTimer(Timer *timer);
+    bool runDue();
+    bool pollPins(Clock::TimePoint now);
+
+    static thread_local EventLoop *running;
+
+    ClockPtr clock;
+    Watchdog::HeartbeatPtr heartbeat;
+    Clock::Alarm alarm;
+
+    // all reserved up front
+    std::vector<std::coroutine_handle<>> ready;
+    std::vector<std::coroutine_handle<>> graveyard;
+    // by time
+    std::vector<Timer*> timers;
+    std::vector<PinWatch*> watches;
+    std::vector<PinWatch*> dueWatches;
+    Clock::TimePoint nextPinPoll;
+    std::vector<MailboxBase*> mailboxes;
+
+    std::thread loopThread;
+    std::atomic<bool> active{true};
+};
+
+class EventLoop::Timer final {
+public:
+    Timer(EventLoop &loop, Clock::TimePoint at): loop{loop}, at{at} {
+    }
+
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+
+    ~Timer() {
+        if(pending) {
+            std::erase(loop.timers, this);
+        }
+    }
+
+    bool await_ready() const {
+        return at <= loop.clock->now();
+    }
+
+    void await_suspend(std::coroutine_handle<> h) {
+        handle = h;
+        loop.addTimer(this);
+        pending = true;
+    }
+
+    void await_resume() const noexcept {
+    }
+
+private:
+    friend class EventLoop;
+
+    EventLoop &loop;
+    Clock::TimePoint at;
+    std::coroutine_handle<> handle;
+    bool pending{false};
+};
+
+class EventLoop::PinWatch final {
+public:
+    PinWatch(EventLoop &loop, BridgePtr bridge, Bridge::PinInputMapping pin, bool level, Clock::TimePoint deadline):
+    loop{loop}, bridge{std::move(bridge)}, pin{pin}, level{level}, deadline{deadline} {
+    }
+
+    PinWatch(const PinWatch&) = delete;
+    PinWatch& operator=(const PinWatch&) = delete;
+
+    ~PinWatch() {
+        if(pending) {
+            std::erase(loop.watches, this);
+        }
+    }
+
+    bool await_ready() {
+        lastRead = bridge->getRaw(pin);
+        stableSince = loop.clock->now();
+        reached = lastRead == level && bridge->getDebounceWindow(pin) == Clock::Duration::zero();
+        if(reached) {
+            bridge->recordDebounced(pin, lastRead);
+        }
+        return reached;
+    }
+
+    void await_suspend(std::coroutine_handle<> h) {
+        handle = h;
+        if(loop.watches.empty()) {
+            loop.nextPinPoll = loop.clock->now() + PIN_POLL;
+        }
+        loop.watches.push_back(this);
+        pending = true;
+    }
+
+    /**
+     * @return false on timeout
+     */
+    bool await_resume() const noexcept {
+        return reached;
+    }
+
+private:
+    friend class EventLoop;
+
+    /**
+     * One raw read per PIN_POLL tick, never sleeps. True once the input
+     * stayed at level for the pin's debounce window.
+     */
+    bool sample(Clock::TimePoint now) {
+        bool s = bridge->getRaw(pin);
+        if(s != lastRead) {
+            lastRead = s;
+            stableSince = now;
+        }
+        if(now - stableSince < bridge->getDebounceWindow(pin)) {
+            return false;
+        }
+        bridge->recordDebounced(pin, lastRead);
+        return lastRead == level;
+    }
+
+    EventLoop &loop;
+    BridgePtr bridge;
+    Bridge::PinInputMapping pin;
+    bool level;
+    // last raw read and since when it holds
+    bool lastRead{false};
+    Clock::TimePoint stableSince;
+    Clock::TimePoint deadline;
+    std::coroutine_handle<> handle;
+    bool pending{false};
+    bool reached{false};
+};
+
+class EventLoop::MailboxBase {
+public:
+    MailboxBase(const MailboxBase&) = delete;
+    MailboxBase& operator=(const MailboxBase&) = delete;
+
+protected:
+    explicit MailboxBase(EventLoop &loop): loop{loop} {
+        loop.mailboxes.push_back(this);
+    }
+
+    ~MailboxBase() noexcept {
+        std::erase(loop.mailboxes, this);
+    }
+
+    void resume(std::coroutine_handle<> h) {
+        loop.resume(h);
+    }
+
+    /**
+     * Hands one message to the waiting task, if there are both.
+     * @return true if a task was resumed
+     */
+    virtual bool dispatch() = 0;
+
+    EventLoop &loop;
+
+private:
+    friend class EventLoop;
+};
+
+/**
+ * Messages for a single receiving task, sent from any thread. Must be created
+ * before the loop starts.
+ */
+template<typename T, std::size_t Capacity = 64>
+class Mailbox final: public EventLoop::MailboxBase {
+public:
+    explicit Mailbox(EventLoop &loop): MailboxBase{loop} {
+    }
+
+    /**
+     * @return false if the mailbox is full, the message is dropped then
+     */
+    bool send(const T &msg) {
+        if(!ring.push(msg)) {
+            return false;
+        }
+        loop.wake();
+        return true;
+    }
+
+    class Receive final {
+    public:
+        explicit Receive(Mailbox &mailbox): mailbox{mailbox} {
+        }
+
+        Receive(const Receive&) = delete;
+        Receive& operator=(const Receive&) = delete;
+
+        ~Receive() {
+            if(mailbox.waiting == this) {
+                mailbox.waiting = nullptr;
+            }
+        }
+
+        bool await_ready() {
+            return mailbox.ring.pop(msg);
+        }
+
+        void await_suspend(std::coroutine_handle<> h) {
+            handle = h;
+            mailbox.waiting = this;
+        }
+
+        T await_resume() const noexcept {
+            return msg;
+        }
+
+    private:
+        friend class Mailbox;
+
+        Mailbox &mailbox;
+        std::coroutine_handle<> handle;
+        T msg{};
+    };
+
+private:
+    bool dispatch() override {
+        if(!waiting || !ring.pop(waiting->msg)) {
+            return false;
+        }
+        auto h = std::exchange(waiting, nullptr)->handle;
+        resume(h);
+        return true;
+    }
+
+    MpscRing<T, Capacity> ring;
+    Receive *waiting{nullptr};
+};
+
+/**
+ * co_await delay(d): resumes the task after d.
+ */
+inline EventLoop::Timer delay(Clock::Duration d) {
+    auto loop = EventLoop::current();
+    return EventLoop::Timer{*loop, loop->getClock()->now() + d};
+}
+
+/**
+ * co_await delayUntil(t): resumes the task at t, e.g. for a fixed rate that
+ * does not add up the oversleep of every step.
+ */
+inline EventLoop::Timer delayUntil(Clock::TimePoint t) {
+    return EventLoop::Timer{*EventLoop::current(), t};
+}
+
+/**
+ * co_await pinEdge(...): resumes the task once the input has held the given
+ * level for its debounce window, at once if it has it and the window is 0.
+ * Inputs are read every PIN_POLL, a level counts as stable if the reads
+ * agreed for the window.
+ * @return false if timeout passed first
+ */
+inline EventLoop::PinWatch pinEdge(BridgePtr bridge, Bridge::PinInputMapping pin, bool level, Clock::Duration timeout) {
+    auto loop = EventLoop::current();
+    return EventLoop::PinWatch{*loop, std::move(bridge), pin, level, loop->getClock()->now() + timeout};
+}
+
+/**
+ * co_await message(mailbox): the next message, the task waits for it if
+ * there is none yet.
+ */
+template<typename T, std::size_t Capacity>
+typename Mailbox<T, Capacity>::Receive message(Mailbox<T, Capacity> &mailbox) {
+    return typename Mailbox<T, Capacity>::Receive{mailbox};
+}
@@ -0,0 +1,71 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <string_view>
+
+/**
+ * String of at most N - 1 chars in place, longer input is cut. Trivially
+ * copyable, so it can be captured by an InplaceFunction or put into shared
+ * memory.
+ */
+template<std::size_t N>
+class FixedString final {
+public:
+    FixedString() = default;
+
+    FixedString(std::string_view str) {
+        append(str);
+    }
+
+    FixedString(const char *str): FixedString{std::string_view{str}} {
+    }
+
+    FixedString& append(std::string_view str) {
+        auto n = std::min(str.size(), N - 1 - size);
+        std::copy_n(str.data(), n, data + size);
+        size += n;
+        data[size] = '\0';
+        return *this;
+    }
+
+    std::string_view view() const {
+        return {data, size};
+    }
+
+    operator std::string_view() const {
+        return view();
+    }
+
+    const char *c_str() const {
+        return data;
+    }
+
+    bool operator==(std::string_view other) const {
+        return view() == other;
+    }
+
+private:
+    char data[N]{};
+    std::size_t size{0};
+};
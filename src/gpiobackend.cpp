@@ -0,0 +1,43 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "gpiobackend.h"
+#include "gpiomembackend.h"
+#include "wiringpibackend.h"
+
+#include <stdexcept>
+#include <syslog.h>
+
+GpioBackendPtr createGpioBackend(const moba::IniPtr &ini, ClockPtr clock) {
+    auto backend = ini->getString("gpio", "backend", "wiringpi");
+
+    if(backend == "wiringpi") {
+        syslog(LOG_INFO, "gpio backend <wiringpi>");
+        return std::make_shared<WiringPiBackend>(clock);
+    }
+
+    if(backend == "gpiomem") {
+        auto device = ini->getString("gpio", "device", GpioMemBackend::DEFAULT_DEVICE);
+        syslog(LOG_INFO, "gpio backend <gpiomem> device <%s>", device.c_str());
+        return std::make_shared<GpioMemBackend>(device);
+    }
+
+    throw std::runtime_error{"unknown gpio backend <" + backend + ">"};
+}
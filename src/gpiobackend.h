@@ -0,0 +1,81 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include <moba-common/ini.h>
+
+#include "clock.h"
+#include "pwmpattern.h"
+
+/**
+ * Low level access to the gpio pins. All pin numbers are wiringPi numbers,
+ * masks carry one bit per wiringPi pin (bit n -> pin n).
+ */
+class GpioBackend {
+public:
+    virtual ~GpioBackend() noexcept = default;
+
+    virtual void setupOutput(int pin) = 0;
+    virtual void setupInput(int pin) = 0;
+
+    /**
+     * Drives all pins in highMask high and all pins in lowMask low. A pin in
+     * both masks ends up low.
+     */
+    virtual void write(std::uint32_t highMask, std::uint32_t lowMask) = 0;
+    virtual bool read(int pin) = 0;
+
+    enum class Pwm {
+        NONE,
+        SOFTWARE,
+        HARDWARE,
+    };
+
+    /**
+     * Hands an output over to PWM if the backend can drive it so; write()
+     * leaves the pin alone from then on. By default no PWM at all.
+     */
+    virtual Pwm setupPwm(int) {
+        return Pwm::NONE;
+    }
+
+    /**
+     * Plays pattern on a pin set up for PWM, replacing the previous one. The
+     * backend keeps the time, the caller is done with this call.
+     */
+    virtual void playPwm(int, const PwmPattern&) {
+    }
+};
+
+using GpioBackendPtr = std::shared_ptr<GpioBackend>;
+
+/**
+ * Creates the backend configured in section [gpio]:
+ *   backend=wiringpi (default) | gpiomem
+ *   device=/dev/gpiomem        (gpiomem only, may point to a plain file)
+ *
+ * PWM is only available with wiringpi: /dev/gpiomem maps the gpio registers
+ * but not the PWM and clock manager blocks. clock times the PWM patterns.
+ */
+GpioBackendPtr createGpioBackend(const moba::IniPtr &ini, ClockPtr clock);
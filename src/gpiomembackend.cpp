@@ -0,0 +1,92 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "gpiomembackend.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+GpioMemBackend::GpioMemBackend(const std::string &device) {
+    fd = open(device.c_str(), O_RDWR | O_SYNC | O_CLOEXEC);
+    if(fd == -1) {
+        throw std::runtime_error{"unable to open <" + device + ">: " + std::strerror(errno)};
+    }
+
+    struct stat st{};
+    if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && static_cast<std::size_t>(st.st_size) < BLOCK_SIZE) {
+        // fake register block for testing
+        if(ftruncate(fd, BLOCK_SIZE) == -1) {
+            auto err = errno;
+            close(fd);
+            throw std::runtime_error{"unable to resize <" + device + ">: " + std::strerror(err)};
+        }
+    }
+
+    auto map = mmap(nullptr, BLOCK_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(map == MAP_FAILED) {
+        auto err = errno;
+        close(fd);
+        throw std::runtime_error{"unable to map <" + device + ">: " + std::strerror(err)};
+    }
+    gpio = static_cast<volatile std::uint32_t*>(map);
+}
+
+GpioMemBackend::~GpioMemBackend() noexcept {
+    munmap(const_cast<std::uint32_t*>(gpio), BLOCK_SIZE);
+    close(fd);
+}
+
+void GpioMemBackend::setupOutput(int pin) {
+    setFunction(pin, 0b001);
+}
+
+void GpioMemBackend::setupInput(int pin) {
+    setFunction(pin, 0b000);
+}
+
+void GpioMemBackend::write(std::uint32_t highMask, std::uint32_t lowMask) {
+    highMask = toBcmMask(highMask & ~lowMask);
+    lowMask = toBcmMask(lowMask);
+
+    if(highMask) {
+        gpio[GPSET0] = highMask;
+    }
+    if(lowMask) {
+        gpio[GPCLR0] = lowMask;
+    }
+}
+
+bool GpioMemBackend::read(int pin) {
+    return gpio[GPLEV0] & (1u << wpiToBcm[pin]);
+}
+
+void GpioMemBackend::setFunction(int pin, std::uint32_t function) {
+    // only called during setup, read-modify-write is fine here
+    auto bcm = wpiToBcm[pin];
+    auto reg = GPFSEL0 + bcm / 10;
+    auto shift = (bcm % 10) * 3;
+    gpio[reg] = (gpio[reg] & ~(0b111u << shift)) | (function << shift);
+}
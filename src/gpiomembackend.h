@@ -0,0 +1,93 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <string>
+
+#include "gpiobackend.h"
+
+/**
+ * Writes the gpio register block directly. The block is mapped from
+ * /dev/gpiomem, for testing any plain file will do (it gets resized to
+ * BLOCK_SIZE). Outputs are driven through the GPSET0 / GPCLR0 registers, so
+ * a whole mask is applied with at most two stores and without any locking.
+ */
+class GpioMemBackend final: public GpioBackend {
+public:
+    static constexpr const char *DEFAULT_DEVICE = "/dev/gpiomem";
+    static constexpr std::size_t BLOCK_SIZE = 4096;
+
+    explicit GpioMemBackend(const std::string &device);
+    ~GpioMemBackend() noexcept override;
+
+    GpioMemBackend(const GpioMemBackend&) = delete;
+    GpioMemBackend& operator=(const GpioMemBackend&) = delete;
+
+    void setupOutput(int pin) override;
+    void setupInput(int pin) override;
+
+    void write(std::uint32_t highMask, std::uint32_t lowMask) override;
+    bool read(int pin) override;
+
+private:
+    // register offsets in 32 bit words
+    enum Register {
+        GPFSEL0 = 0x00 / 4,
+        GPSET0  = 0x1C / 4,
+        GPCLR0  = 0x28 / 4,
+        GPLEV0  = 0x34 / 4,
+    };
+
+    void setFunction(int pin, std::uint32_t function);
+
+    // wiringPi pin -> BCM gpio (Pi 2 and later)
+    static constexpr std::array<int, 32> wpiToBcm{
+        17, 18, 27, 22, 23, 24, 25,  4,  2,  3,  8,  7, 10,  9, 11, 14,
+        15, 28, 29, 30, 31,  5,  6, 13, 19, 26, 12, 16, 20, 21,  0,  1
+    };
+
+    // per byte lookup, turns a wiringPi mask into a BCM mask with four loads
+    using MaskTable = std::array<std::array<std::uint32_t, 256>, 4>;
+
+    static constexpr MaskTable maskTable = [] {
+        MaskTable t{};
+        for(int b = 0; b < 4; ++b) {
+            for(int v = 0; v < 256; ++v) {
+                for(int bit = 0; bit < 8; ++bit) {
+                    if(v & (1 << bit)) {
+                        t[b][v] |= 1u << wpiToBcm[b * 8 + bit];
+                    }
+                }
+            }
+        }
+        return t;
+    }();
+
+    static constexpr std::uint32_t toBcmMask(std::uint32_t wpiMask) {
+        return
+            maskTable[0][wpiMask & 0xFF] | maskTable[1][(wpiMask >> 8) & 0xFF] |
+            maskTable[2][(wpiMask >> 16) & 0xFF] | maskTable[3][wpiMask >> 24];
+    }
+
+    volatile std::uint32_t *gpio;
+    int fd;
+};
@@ -0,0 +1,148 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "heapguard.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+    std::atomic<bool> sealed{false};
+    std::atomic<bool> strictMode{false};
+
+    std::atomic<std::uint64_t> allocations{0};
+    std::atomic<std::uint64_t> guarded{0};
+    std::atomic<std::uint64_t> guardedBytes{0};
+    std::atomic<std::uint64_t> unguarded{0};
+
+    thread_local bool guardedThread = false;
+    thread_local int exempt = 0;
+
+    [[maybe_unused]] void account(std::size_t size) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        if(!sealed.load(std::memory_order_relaxed) || exempt) {
+            return;
+        }
+        if(!guardedThread) {
+            unguarded.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        guarded.fetch_add(1, std::memory_order_relaxed);
+        guardedBytes.fetch_add(size, std::memory_order_relaxed);
+        if(strictMode.load(std::memory_order_relaxed)) {
+            std::abort();
+        }
+    }
+}
+
+void HeapGuard::guardThread() {
+    guardedThread = true;
+}
+
+void HeapGuard::seal(bool strict) {
+    strictMode = strict;
+    sealed = true;
+}
+
+void HeapGuard::unseal() {
+    sealed = false;
+}
+
+HeapGuard::Stats HeapGuard::getStats() {
+    return Stats{allocations.load(), guarded.load(), guardedBytes.load(), unguarded.load()};
+}
+
+HeapGuard::Exempt::Exempt() {
+    ++exempt;
+}
+
+HeapGuard::Exempt::~Exempt() {
+    --exempt;
+}
+
+#ifdef MOBA_HEAP_GUARD
+
+void *operator new(std::size_t size) {
+    account(size);
+    if(auto p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void *operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void *operator new(std::size_t size, std::align_val_t align) {
+    account(size);
+    auto a = static_cast<std::size_t>(align);
+    if(auto p = std::aligned_alloc(a, (size + a - 1) / a * a)) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void *operator new[](std::size_t size, std::align_val_t align) {
+    return operator new(size, align);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    account(size);
+    return std::malloc(size ? size : 1);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+#endif
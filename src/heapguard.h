@@ -0,0 +1,84 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Instrumented global allocator, compiled in with the build option
+ * HEAP_GUARD (MOBA_HEAP_GUARD). Once the daemon is set up, seal() ends the
+ * init phase; from then on every heap allocation on a guarded thread (the
+ * message path and the control loops) is counted, and with strict mode the
+ * daemon aborts right there, so a debugger or the core dump shows the
+ * culprit. Allocations on other threads (e.g. message decoding in
+ * lib-msghandling) are counted separately.
+ *
+ * Without the build option only the bookkeeping calls remain, all counts
+ * stay 0.
+ */
+class HeapGuard final {
+public:
+#ifdef MOBA_HEAP_GUARD
+    static constexpr bool ENABLED = true;
+#else
+    static constexpr bool ENABLED = false;
+#endif
+
+    struct Stats {
+        // since process start
+        std::uint64_t allocations;
+        // after seal()
+        std::uint64_t guarded;
+        std::uint64_t guardedBytes;
+        std::uint64_t unguarded;
+    };
+
+    HeapGuard() = delete;
+
+    /**
+     * Marks the calling thread as guarded, call it first thing in the thread.
+     */
+    static void guardThread();
+
+    static void seal(bool strict);
+
+    /**
+     * Back to the init phase, e.g. for the shutdown.
+     */
+    static void unseal();
+
+    static Stats getStats();
+
+    /**
+     * Allocations in scope are not counted, for the few places that have to
+     * hand data to a library that allocates (sending a message, starting a
+     * thread).
+     */
+    class Exempt final {
+    public:
+        Exempt();
+        ~Exempt();
+
+        Exempt(const Exempt&) = delete;
+        Exempt& operator=(const Exempt&) = delete;
+    };
+};
@@ -0,0 +1,111 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * void() callable stored in place, never on the heap. A callable bigger
+ * than Size does not compile, so a capture that grows too much is caught
+ * at build time. Move only.
+ */
+template<std::size_t Size>
+class InplaceFunction final {
+public:
+    InplaceFunction() = default;
+
+    template<typename F>
+    requires (!std::is_same_v<std::decay_t<F>, InplaceFunction> && std::is_invocable_r_v<void, std::decay_t<F>&>)
+    InplaceFunction(F &&f) {
+        using T = std::decay_t<F>;
+        static_assert(sizeof(T) <= Size, "captures too big, raise Size or capture less");
+        static_assert(alignof(T) <= alignof(std::max_align_t));
+        static_assert(std::is_nothrow_move_constructible_v<T>);
+        ::new(static_cast<void*>(storage)) T(std::forward<F>(f));
+        ops = &OPS<T>;
+    }
+
+    InplaceFunction(InplaceFunction &&other) noexcept {
+        moveFrom(other);
+    }
+
+    InplaceFunction& operator=(InplaceFunction &&other) noexcept {
+        if(this != &other) {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    ~InplaceFunction() {
+        reset();
+    }
+
+    void operator()() {
+        ops->call(storage);
+    }
+
+    explicit operator bool() const {
+        return ops != nullptr;
+    }
+
+    void reset() {
+        if(ops) {
+            ops->destroy(storage);
+            ops = nullptr;
+        }
+    }
+
+private:
+    struct Ops {
+        void (*call)(void*);
+        // move constructs into to and destroys from
+        void (*relocate)(void *to, void *from);
+        void (*destroy)(void*);
+    };
+
+    template<typename T>
+    static constexpr Ops OPS{
+        [](void *p) {
+            (*static_cast<T*>(p))();
+        },
+        [](void *to, void *from) {
+            ::new(to) T(std::move(*static_cast<T*>(from)));
+            static_cast<T*>(from)->~T();
+        },
+        [](void *p) {
+            static_cast<T*>(p)->~T();
+        },
+    };
+
+    void moveFrom(InplaceFunction &other) {
+        if(other.ops) {
+            other.ops->relocate(storage, other.storage);
+            ops = std::exchange(other.ops, nullptr);
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage[Size];
+    const Ops *ops{nullptr};
+};
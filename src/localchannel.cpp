@@ -0,0 +1,188 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "localchannel.h"
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <stdexcept>
+#include <syslog.h>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// shared between processes, only address free atomics work
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+namespace {
+    std::uint32_t *futexWord(std::atomic<std::uint32_t> &a) {
+        return reinterpret_cast<std::uint32_t*>(&a);
+    }
+
+    void futexWait(std::atomic<std::uint32_t> &a, std::uint32_t expected, std::chrono::milliseconds timeout) {
+        timespec ts{
+            static_cast<time_t>(timeout.count() / 1000),
+            static_cast<long>((timeout.count() % 1000) * 1000000)
+        };
+        // shared futex: the word is mapped by several processes
+        syscall(SYS_futex, futexWord(a), FUTEX_WAIT, expected, &ts, nullptr, 0);
+    }
+
+    void futexWake(std::atomic<std::uint32_t> &a) {
+        syscall(SYS_futex, futexWord(a), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+    }
+}
+
+LocalChannel::LocalChannel(const std::string &name, Mode mode): name{name}, mode{mode} {
+    int flags = O_RDWR | O_CLOEXEC;
+    if(mode == Mode::OWNER) {
+        flags |= O_CREAT;
+    }
+
+    int fd = shm_open(name.c_str(), flags, 0660);
+    if(fd == -1) {
+        throw std::runtime_error{"unable to open local channel <" + name + ">: " + std::strerror(errno)};
+    }
+
+    if(mode == Mode::OWNER) {
+        // the lock goes with the owner process, also when it crashed
+        if(flock(fd, LOCK_EX | LOCK_NB) == -1) {
+            auto err = errno;
+            close(fd);
+            if(err == EWOULDBLOCK) {
+                throw std::runtime_error{"local channel <" + name + "> is owned by a running daemon"};
+            }
+            throw std::runtime_error{"unable to lock local channel <" + name + ">: " + std::strerror(err)};
+        }
+        // a stale segment of a crashed daemon must not be reused: truncated, it is zero filled again
+        if(ftruncate(fd, 0) == -1 || ftruncate(fd, sizeof(Segment)) == -1) {
+            auto err = errno;
+            close(fd);
+            throw std::runtime_error{"unable to resize local channel <" + name + ">: " + std::strerror(err)};
+        }
+    }
+
+    auto map = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    auto err = errno;
+    if(mode == Mode::OWNER && map != MAP_FAILED) {
+        this->fd = fd;
+    } else {
+        close(fd);
+    }
+    if(map == MAP_FAILED) {
+        throw std::runtime_error{"unable to map local channel <" + name + ">: " + std::strerror(err)};
+    }
+    segment = static_cast<Segment*>(map);
+
+    if(mode == Mode::CLIENT) {
+        if(segment->magic != MAGIC || segment->size != sizeof(Segment)) {
+            munmap(segment, sizeof(Segment));
+            throw std::runtime_error{"local channel <" + name + "> has an incompatible layout"};
+        }
+        return;
+    }
+
+    // fresh segment is zero filled
+    new(&segment->signal) std::atomic<std::uint32_t>{0};
+    new(&segment->sleeping) std::atomic<std::uint32_t>{0};
+    new(&segment->ring) MpscRing<LocalCommand, CAPACITY>{};
+    segment->size = sizeof(Segment);
+    std::atomic_thread_fence(std::memory_order_release);
+    segment->magic = MAGIC;
+}
+
+LocalChannel::~LocalChannel() noexcept {
+    munmap(segment, sizeof(Segment));
+    if(mode == Mode::OWNER) {
+        shm_unlink(name.c_str());
+        close(fd);
+    }
+}
+
+bool LocalChannel::send(LocalCommand cmd) {
+    cmd.sentAt = now();
+    if(!segment->ring.push(cmd)) {
+        return false;
+    }
+    segment->signal.fetch_add(1, std::memory_order_seq_cst);
+    if(segment->sleeping.load(std::memory_order_seq_cst)) {
+        futexWake(segment->signal);
+    }
+    return true;
+}
+
+bool LocalChannel::receive(LocalCommand &cmd, std::chrono::milliseconds timeout) {
+    if(tryReceive(cmd)) {
+        return true;
+    }
+
+    auto signal = segment->signal.load(std::memory_order_seq_cst);
+    segment->sleeping.store(1, std::memory_order_seq_cst);
+
+    // a producer may have slipped in between the first try and announcing the sleep
+    if(tryReceive(cmd)) {
+        segment->sleeping.store(0, std::memory_order_relaxed);
+        return true;
+    }
+    futexWait(segment->signal, signal, timeout);
+    segment->sleeping.store(0, std::memory_order_relaxed);
+    return tryReceive(cmd);
+}
+
+bool LocalChannel::tryReceive(LocalCommand &cmd) {
+    if(segment->ring.pop(cmd)) {
+        blockedSince = 0;
+        return true;
+    }
+    if(!segment->ring.blocked()) {
+        blockedSince = 0;
+        return false;
+    }
+    auto t = now();
+    if(!blockedSince) {
+        blockedSince = t;
+        return false;
+    }
+    if(std::chrono::nanoseconds{t - blockedSince} < BLOCKED_TIMEOUT) {
+        return false;
+    }
+    // the sender died between claiming the slot and publishing it
+    blockedSince = 0;
+    if(segment->ring.skip()) {
+        syslog(
+            LOG_WARNING, "local channel <%s>: slot not sent within %lld ms, skipped", name.c_str(),
+            static_cast<long long>(BLOCKED_TIMEOUT.count())
+        );
+    }
+    return segment->ring.pop(cmd);
+}
+
+std::int64_t LocalChannel::now() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<std::int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
@@ -0,0 +1,137 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "mpscring.h"
+
+/**
+ * Command sent by a local tool. Lives in shared memory, so it has to stay a
+ * trivially copyable type.
+ */
+struct LocalCommand {
+    enum class Type: std::uint8_t {
+        AMBIENCE     = 1,
+        CURTAIN_UP   = 2,
+        CURTAIN_DOWN = 3,
+        EFFECT       = 4,
+        SCENE        = 5,
+        CALIBRATE    = 6,
+    };
+
+    // same meaning as ToggleState in EnvSetAmbience
+    enum class Toggle: std::int8_t {
+        UNSET = -1,
+        OFF   = 0,
+        ON    = 1,
+    };
+
+    static constexpr std::size_t NAME_SIZE = 32;
+
+    Type type;
+    Toggle curtainUp{Toggle::UNSET};
+    Toggle mainLightOn{Toggle::UNSET};
+    // effect or scene name
+    char name[NAME_SIZE]{};
+    // input characterisation in s
+    std::uint32_t duration{0};
+    // effect: at the same moment on all synchronised nodes
+    bool synced{false};
+
+    // CLOCK_MONOTONIC in ns, set by send()
+    std::int64_t sentAt{0};
+};
+
+/**
+ * An MpscRing in POSIX shared memory. The daemon owns (creates) the segment
+ * and is the only consumer, local tools attach and send. The owner holds a
+ * lock on the segment as long as it lives, a second owner is refused. An empty ring parks
+ * the consumer on a futex, producers only issue the wake syscall while the
+ * consumer is actually sleeping. A slot left blocked by a tool that died
+ * while sending is skipped after BLOCKED_TIMEOUT.
+ */
+class LocalChannel final {
+public:
+    static constexpr const char *DEFAULT_NAME = "/moba-environment";
+    static constexpr std::uint32_t CAPACITY = 256;
+    static constexpr std::chrono::milliseconds BLOCKED_TIMEOUT{1000};
+
+    enum class Mode {
+        OWNER,
+        CLIENT
+    };
+
+    /**
+     * @throws std::runtime_error if the segment cannot be set up, or (OWNER)
+     * if another daemon owns it
+     */
+    LocalChannel(const std::string &name, Mode mode);
+    ~LocalChannel() noexcept;
+
+    LocalChannel(const LocalChannel&) = delete;
+    LocalChannel& operator=(const LocalChannel&) = delete;
+
+    /**
+     * @return false if the ring is full
+     */
+    bool send(LocalCommand cmd);
+
+    /**
+     * Blocks up to timeout for the next command (consumer only).
+     * @return false on timeout
+     */
+    bool receive(LocalCommand &cmd, std::chrono::milliseconds timeout);
+
+    static std::int64_t now();
+
+private:
+    static constexpr std::uint32_t MAGIC = 0x4D4F4241; // MOBA
+
+    struct Segment {
+        std::uint32_t magic;
+        // of the whole segment, tools built against another layout refuse it
+        std::uint32_t size;
+
+        // futex word, bumped on every send
+        alignas(64) std::atomic<std::uint32_t> signal;
+        std::atomic<std::uint32_t> sleeping;
+
+        MpscRing<LocalCommand, CAPACITY> ring;
+    };
+
+    bool tryReceive(LocalCommand &cmd);
+
+    std::string name;
+    Mode mode;
+    Segment *segment;
+    // owner only, keeps the lock
+    int fd{-1};
+
+    // consumer only: since when the next slot is blocked, 0 if it is not
+    std::int64_t blockedSince{0};
+};
+
+using LocalChannelPtr = std::shared_ptr<LocalChannel>;
@@ -20,18 +20,36 @@
 
 #include <config.h>
 
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
 #include <memory>
+#include <syslog.h>
+#include <sys/socket.h>
 
 #include <moba-common/daemon.h>
 #include <moba-common/ini.h>
 #include <moba-common/version.h>
 #include <moba-common/helper.h>
-#include <moba-common/ipc.h>
 
 #include "bridge.h"
+#include "clock.h"
+#include "clocksync.h"
+#include "debouncecalibration.h"
+#include "gpiobackend.h"
 #include "eclipsecontrol.h"
+#include "eventloop.h"
+#include "heapguard.h"
 #include "statuscontrol.h"
 #include "msgloop.h"
+#include "scenetable.h"
+#include "shutdowncontrol.h"
+#include "soundengine.h"
+#include "soundsink.h"
+#include "syncmessages.h"
+#include "telemetry.h"
+#include "watchdog.h"
+#include "localchannel.h"
 #include "moba/endpoint.h"
 #include "moba/socket.h"
 
@@ -59,7 +77,18 @@ int main(const int argc, char *argv[]) {
 
     auto ini = std::make_shared<moba::Ini>(std::string{SYSCONFIR} + "/" + PACKAGE_NAME + ".conf");
 
-    int key = ini->getInt("settings", "ipc_key", moba::IPC::DEFAULT_KEY);
+    // first, a second instance must not touch the pins or take the channel over
+    LocalChannelPtr local;
+    try {
+        local = std::make_shared<LocalChannel>(
+            ini->getString("settings", "local_channel", LocalChannel::DEFAULT_NAME),
+            LocalChannel::Mode::OWNER
+        );
+    } catch(const std::exception &e) {
+        syslog(LOG_CRIT, "%s", e.what());
+        return EXIT_FAILURE;
+    }
+
     appData.port = ini->getInt("settings", "port", appData.port);
     appData.host = ini->getString("settings", "host", appData.host);
 
@@ -73,16 +102,77 @@ int main(const int argc, char *argv[]) {
     }};
 
 
-    auto bridge = std::make_shared<Bridge>();
-    auto status = std::make_shared<StatusControl>(bridge, endpoint);
-    auto eclctr = std::make_shared<EclipseControl>(bridge, ini);
+    auto clock = std::make_shared<SystemClock>();
+    auto telemetry = std::make_shared<Telemetry>(endpoint, ini, clock);
+    auto bridge = std::make_shared<Bridge>(createGpioBackend(ini, clock), clock, telemetry);
+
+    // first, blocks the shutdown signals for every thread started later on
+    auto shutdown = std::make_shared<ShutdownControl>(bridge, ini);
+    telemetry->start();
 
+    // before the first task, the eclipse control spawns them
+    Task::reserveFrames(
+        std::max(ini->getInt("memory", "frames", 16), 1), std::max(ini->getInt("memory", "frame_size", 1024), 64)
+    );
 
+    auto watchdog = std::make_shared<Watchdog>(bridge, ini, clock);
+    auto status = std::make_shared<StatusControl>(bridge, ini, endpoint, clock, watchdog, shutdown);
+    auto eclctr = std::make_shared<EclipseControl>(bridge, ini, clock, watchdog, telemetry);
 
+    auto sound = std::make_shared<SoundEngine>(createSoundSink(ini, clock), ini, clock);
 
-    //auto ipc = std::make_shared<moba::IPC>(key, moba::IPC::TYPE_CLIENT);
+    telemetry->addCounter(Telemetry::Counter::WATCHDOG_STALLS, [watchdog]{return watchdog->getStats().stalls;});
+    telemetry->addCounter(Telemetry::Counter::SOUND_DROPPED, [sound]{return sound->getStats().dropped;});
+    telemetry->addCounter(Telemetry::Counter::LIGHT_FAILURES, [eclctr]{return eclctr->getLightStats().failures;});
 
-    MessageLoop loop{endpoint, status, eclctr, bridge};
-    loop.run();
-    exit(EXIT_SUCCESS);
+    auto scenes = std::make_shared<SceneTable>(ini);
+    auto calibration = std::make_shared<DebounceCalibration>(bridge, ini, clock);
+
+    auto sync = std::make_shared<ClockSync>(ini, clock);
+    sync->start([endpoint](const ClockSync::Ping &ping) {
+        endpoint->sendMsg(EnvClockPing{ping.node, ping.seq, ping.sent});
+    });
+
+    MessageLoop loop{endpoint, status, eclctr, bridge, clock, watchdog, {
+        .local = local,
+        .shutdown = shutdown,
+        .sound = sound,
+        .scenes = scenes,
+        .calibration = calibration,
+        .sync = sync,
+        .jobs = static_cast<std::size_t>(std::max(ini->getInt("memory", "jobs", 256), 1))
+    }};
+    loop.start();
+
+    telemetry->addCounter(Telemetry::Counter::HEAP_AFTER_INIT, []{return HeapGuard::getStats().guarded;});
+    telemetry->addCounter(Telemetry::Counter::JOBS_REJECTED, [&loop]{return loop.rejectedJobs();});
+
+    // shutting the socket down makes the blocked read fail, so stop() can join the thread
+    loop.startReceiving([socket]{::shutdown(socket->getSocket(), SHUT_RDWR);});
+
+    // from here on the guarded threads run on what they reserved
+    HeapGuard::seal(ini->getInt("memory", "strict", 0) != 0);
+
+    // the curtain motor first
+    shutdown->addPhase("eclipse control", [eclctr]{eclctr->stop();});
+    shutdown->addPhase("heap guard", [] {
+        HeapGuard::unseal();
+        auto stats = HeapGuard::getStats();
+        syslog(
+            stats.guarded ? LOG_WARNING : LOG_INFO, "heap after init: %llu allocations (%llu bytes), %llu unguarded, %zu task frames",
+            static_cast<unsigned long long>(stats.guarded), static_cast<unsigned long long>(stats.guardedBytes),
+            static_cast<unsigned long long>(stats.unguarded), Task::frameOverflows()
+        );
+    });
+    shutdown->addPhase("save state", [eclctr]{eclctr->saveState();});
+    shutdown->addPhase("message loop", [&loop]{loop.stop();});
+    shutdown->addPhase("debounce calibration", [calibration]{calibration->stop();});
+    shutdown->addPhase("clock sync", [sync]{sync->stop();});
+    shutdown->addPhase("status control", [status]{status->stop();});
+    shutdown->addPhase("sound", [sound]{sound->stopMixer();});
+    shutdown->addPhase("watchdog", [watchdog]{watchdog->stop();});
+    shutdown->addPhase("telemetry", [telemetry]{telemetry->stop();});
+    shutdown->run();
+
+    return EXIT_SUCCESS;
 }
@@ -0,0 +1,129 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * Bounded multi producer / single consumer ring (Vyukov). Neither side ever
+ * blocks or allocates. It holds no pointers, so it also works placed in
+ * shared memory with the producers in other processes (see LocalChannel).
+ */
+template<typename T, std::size_t Capacity>
+class MpscRing final {
+    static_assert(std::is_trivially_copyable_v<T>);
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+    MpscRing() {
+        for(std::size_t i = 0; i < Capacity; ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    /**
+     * @return false if the ring is full, or if the consumer gave up on the
+     * slot meanwhile (see skip())
+     */
+    bool push(const T &value) {
+        auto pos = enqueuePos.load(std::memory_order_relaxed);
+        Slot *slot;
+        while(true) {
+            slot = &slots[pos & (Capacity - 1)];
+            auto seq = slot->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::int64_t>(seq) - static_cast<std::int64_t>(pos);
+            if(diff == 0) {
+                if(enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if(diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        slot->value = value;
+        // fails only if the slot was skipped, the value is lost then
+        return slot->sequence.compare_exchange_strong(pos, pos + 1, std::memory_order_release, std::memory_order_relaxed);
+    }
+
+    /**
+     * Consumer only.
+     * @return false if the ring is empty
+     */
+    bool pop(T &value) {
+        auto &slot = slots[dequeuePos & (Capacity - 1)];
+        if(slot.sequence.load(std::memory_order_acquire) != dequeuePos + 1) {
+            return false;
+        }
+        value = slot.value;
+        slot.sequence.store(dequeuePos + Capacity, std::memory_order_release);
+        ++dequeuePos;
+        return true;
+    }
+
+    /**
+     * Consumer only: the next slot was claimed by a producer that has not
+     * published it yet. Normally for a few ns; a producer process that died
+     * right there leaves it blocked for good, and everything behind it.
+     */
+    bool blocked() const {
+        const auto &slot = slots[dequeuePos & (Capacity - 1)];
+        return enqueuePos.load(std::memory_order_acquire) != dequeuePos &&
+            slot.sequence.load(std::memory_order_acquire) == dequeuePos;
+    }
+
+    /**
+     * Consumer only: gives up on the next slot if it is still blocked and
+     * hands it back to the producers. A producer that publishes it afterwards
+     * gets false from push(); one still writing it may garble the next value
+     * put there, so only skip after far longer than any push takes.
+     * @return true if the slot was skipped
+     */
+    bool skip() {
+        if(enqueuePos.load(std::memory_order_acquire) == dequeuePos) {
+            return false;
+        }
+        auto &slot = slots[dequeuePos & (Capacity - 1)];
+        auto expected = dequeuePos;
+        if(!slot.sequence.compare_exchange_strong(expected, dequeuePos + Capacity, std::memory_order_acq_rel)) {
+            return false;
+        }
+        ++dequeuePos;
+        return true;
+    }
+
+private:
+    struct Slot {
+        std::atomic<std::uint64_t> sequence;
+        T value;
+    };
+
+    alignas(64) std::atomic<std::uint64_t> enqueuePos{0};
+    alignas(64) std::uint64_t dequeuePos{0};
+    alignas(64) Slot slots[Capacity];
+};
@@ -22,27 +22,120 @@
 #include "moba/registry.h"
 #include "moba/timermessages.h"
 #include "moba/environmentmessages.h"
+#include "syncmessages.h"
+#include "heapguard.h"
 
-#include <moba-common/ipc.h>
+#include <cstring>
+#include <optional>
 #include <thread>
+#include <utility>
 #include <syslog.h>
 
-MessageLoop::MessageLoop(EndpointPtr endpoint, StatusControlPtr status, EclipseControlPtr eclctr, BridgePtr bridge) :
-endpoint{endpoint}, status{status}, eclctr{eclctr}, bridge{bridge} {
+namespace {
+    /**
+     * "rain" and "rain.off" share their target, the later one wins
+     */
+    MessageScheduler::Target effectTarget(std::string_view effect) {
+        MessageScheduler::Target target{"effect."};
+        target.append(effect.substr(0, effect.find('.')));
+        return target;
+    }
+}
+
+MessageLoop::MessageLoop(
+    EndpointPtr endpoint, StatusControlPtr status, EclipseControlPtr eclctr, BridgePtr bridge,
+    ClockPtr clock, WatchdogPtr watchdog, const Options &options
+) : endpoint{endpoint}, status{status}, eclctr{eclctr}, bridge{bridge}, local{options.local}, clock{clock},
+shutdownControl{options.shutdown}, sound{options.sound}, scenes{options.scenes}, calibration{options.calibration},
+sync{options.sync}, scheduler{clock, options.jobs} {
+    dispatchHeartbeat = watchdog->registerLoop("dispatch", std::chrono::milliseconds{2000});
+}
+
+MessageLoop::~MessageLoop() {
+    stop();
+}
+
+void MessageLoop::start() {
+    dispatchThread = std::thread{[this] {
+        HeapGuard::guardThread();
+        dispatchControl();
+    }};
+    if(local) {
+        localChannelThread = std::thread{[this] {
+            HeapGuard::guardThread();
+            localChannelControl();
+        }};
+    }
+}
+
+void MessageLoop::startReceiving(std::function<void()> disconnect) {
+    this->disconnect = std::move(disconnect);
+    receiveThread = std::thread{[this]{run();}};
+}
+
+void MessageLoop::stop() {
+    closing = true;
+    if(receiveThread.joinable()) {
+        disconnect();
+        receiveThread.join();
+    }
+    if(localChannelThread.joinable()) {
+        localChannelThread.join();
+    }
+    if(dispatchThread.joinable()) {
+        dispatchThread.join();
+    }
 }
 
 void MessageLoop::run() {
+    using Lane = MessageScheduler::Lane;
+
+    // the registry only decodes and classifies, the handlers run in the dispatch thread;
+    // built once, the handlers survive reconnects
+    Registry registry;
+    registry.registerHandler<SystemHardwareStateChanged>([this](const SystemHardwareStateChanged &data) {
+        enqueueHardwareState(data.hardwareState);
+    });
+    // not queued, the shutdown must not wait behind a stuck dispatch
+    registry.registerHandler<ClientShutdown>([this]{shutdown();});
+    registry.registerHandler<ClientReset>([this]{reboot();});
+    //registry.registerHandler<ClientSelfTesting>([this]{bridge->selftesting();});
+    registry.registerHandler<ClientError>([this](const ClientError &data) {
+        // copied into the job, the decoded strings go with the message
+        scheduler.push(Lane::CONTROL, [this, errorId = FixedString<32>{data.errorId}, msg = FixedString<96>{data.additionalMsg}] {
+            setError(errorId.c_str(), msg.c_str());
+        });
+    });
+    registry.registerHandler<EnvSetAmbience>([this](const EnvSetAmbience &data) {
+        enqueueAmbience(data.curtainUp, data.mainLightOn);
+    });
+
+    // answered right here, any queueing would show up as offset
+    registry.registerHandler<EnvClockPing>([this](const EnvClockPing &data) {
+        if(sync && sync->getMode() == ClockSync::Mode::REFERENCE) {
+            auto pong = sync->answer({data.node, data.seq, data.sent});
+            HeapGuard::Exempt exempt;
+            endpoint->sendMsg(EnvClockPong{pong.node, pong.seq, pong.sent, pong.received, pong.replied});
+        }
+    });
+    registry.registerHandler<EnvClockPong>([this](const EnvClockPong &data) {
+        if(sync) {
+            sync->onPong({data.node, data.seq, data.sent, data.received, data.replied});
+        }
+    });
+    registry.registerHandler<EnvSyncedEffect>([this](const EnvSyncedEffect &data) {
+        if(!sync || sync->getMode() == ClockSync::Mode::OFF || data.node == sync->getNode()) {
+            return;
+        }
+        auto at = sync->toLocal(data.at);
+        scheduler.pushCosmetic(effectTarget(data.effect), [this, effect = Name{data.effect}, at] {
+            setEffect(effect, at);
+        });
+    });
 
     while(!closing) {
         try {
             endpoint->connect();
-            Registry registry;
-            registry.registerHandler<SystemHardwareStateChanged>(std::bind(&MessageLoop::setHardwareState, this, std::placeholders::_1));
-            registry.registerHandler<ClientShutdown>([this]{shutdown();});
-            registry.registerHandler<ClientReset>([this]{reboot();});
-            //registry.registerHandler<ClientSelfTesting>([this]{bridge->selftesting();});
-            registry.registerHandler<ClientError>(std::bind(&MessageLoop::setError, this, std::placeholders::_1));
-            registry.registerHandler<EnvSetAmbience>(std::bind(&MessageLoop::setAmbience, this, std::placeholders::_1));
 
             endpoint->sendMsg(SystemGetHardwareState{});
             endpoint->sendMsg(TimerGetGlobalTimer{});
@@ -57,16 +150,144 @@ void MessageLoop::run() {
                 registry.handleMsg(endpoint->waitForNewMsg());
             }
         } catch(const std::exception &e) {
+            // the read fails once stop() disconnected
+            if(closing) {
+                break;
+            }
             syslog(LOG_CRIT, "exception occured! <%s> started", e.what());
             status->setStatusBar(StatusControl::StatusBarState::ERROR);
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds{500});
+        clock->sleepFor(std::chrono::milliseconds{500});
+    }
+}
+
+void MessageLoop::dispatchControl() {
+    while(!closing) {
+        dispatchHeartbeat->beat();
+        try {
+            scheduler.dispatchNext(std::chrono::milliseconds{500});
+        } catch(const std::exception &e) {
+            syslog(LOG_CRIT, "exception in dispatch occured! <%s>", e.what());
+        }
+    }
+    dispatchHeartbeat->pause();
+}
+
+void MessageLoop::dispatchPending() {
+    while(scheduler.dispatchNext(std::chrono::milliseconds{0})) {
+    }
+}
+
+void MessageLoop::enqueueHardwareState(SystemHardwareStateChanged::HardwareState state) {
+    scheduler.push(MessageScheduler::Lane::SAFETY, [this, state]{setHardwareState(state);});
+}
+
+void MessageLoop::enqueueAmbience(ToggleState curtainUp, ToggleState mainLightOn) {
+    // one cosmetic target per output, so a later command only supersedes what it really changes
+    if(curtainUp != ToggleState::UNSET) {
+        scheduler.pushCosmetic("ambience.curtain", [this, curtainUp] {
+            setAmbience(EnvSetAmbience{curtainUp, ToggleState::UNSET});
+        });
+    }
+    if(mainLightOn != ToggleState::UNSET) {
+        scheduler.pushCosmetic("ambience.mainLight", [this, mainLightOn] {
+            setAmbience(EnvSetAmbience{ToggleState::UNSET, mainLightOn});
+        });
+    }
+}
+
+void MessageLoop::localChannelControl() {
+    while(!closing) {
+        LocalCommand cmd;
+        if(!local->receive(cmd, std::chrono::milliseconds{500})) {
+            continue;
+        }
+        enqueueLocal(cmd);
+    }
+}
+
+void MessageLoop::enqueueLocal(const LocalCommand &cmd) {
+    using Lane = MessageScheduler::Lane;
+
+    auto toToggleState = [](LocalCommand::Toggle t) {
+        switch(t) {
+            case LocalCommand::Toggle::ON:
+                return ToggleState::ON;
+
+            case LocalCommand::Toggle::OFF:
+                return ToggleState::OFF;
+
+            default:
+                return ToggleState::UNSET;
+        }
+    };
+
+    switch(cmd.type) {
+        case LocalCommand::Type::AMBIENCE:
+            enqueueAmbience(toToggleState(cmd.curtainUp), toToggleState(cmd.mainLightOn));
+            break;
+
+        // toggles, collapsing two of them would change the outcome
+        case LocalCommand::Type::CURTAIN_UP:
+            scheduler.push(Lane::CONTROL, [this] {
+                currentScene = SceneTable::NONE;
+                eclctr->curtainRunningUp();
+            });
+            break;
+
+        case LocalCommand::Type::CURTAIN_DOWN:
+            scheduler.push(Lane::CONTROL, [this] {
+                currentScene = SceneTable::NONE;
+                eclctr->curtainRunningDown();
+            });
+            break;
+
+        case LocalCommand::Type::SCENE:
+            enqueueScene({cmd.name, strnlen(cmd.name, LocalCommand::NAME_SIZE)});
+            break;
+
+        case LocalCommand::Type::EFFECT: {
+            std::string_view effect{cmd.name, strnlen(cmd.name, LocalCommand::NAME_SIZE)};
+            if(cmd.synced) {
+                enqueueSyncedEffect(effect);
+                break;
+            }
+            scheduler.pushCosmetic(effectTarget(effect), [this, effect = Name{effect}] {
+                setEffect(effect);
+            });
+            break;
+        }
+
+        case LocalCommand::Type::CALIBRATE:
+            scheduler.push(Lane::CONTROL, [this, duration = cmd.duration] {
+                // starts the sampling thread, std::thread allocates its state
+                HeapGuard::Exempt exempt;
+                if(!calibration) {
+                    syslog(LOG_WARNING, "debounce calibration not available");
+                } else if(!calibration->start(std::chrono::seconds{duration})) {
+                    syslog(LOG_WARNING, "debounce calibration already running");
+                }
+            });
+            break;
+
+        default:
+            syslog(LOG_WARNING, "enqueueLocal: unknown command <%d>", static_cast<int>(cmd.type));
+            break;
     }
 }
 
-void MessageLoop::setHardwareState(const SystemHardwareStateChanged &data) {
+void MessageLoop::enqueueScene(std::string_view name) {
+    // a newer scene replaces one still queued
+    scheduler.pushCosmetic("scene", [this, name = Name{name}]{setScene(name);});
+}
+
+void MessageLoop::enqueueSyncedEffect(std::string_view effect) {
+    scheduler.pushCosmetic(effectTarget(effect), [this, effect = Name{effect}]{setSyncedEffect(effect);});
+}
+
+void MessageLoop::setHardwareState(SystemHardwareStateChanged::HardwareState state) {
 
-    switch(data.hardwareState) {
+    switch(state) {
         case SystemHardwareStateChanged::HardwareState::ERROR:
             syslog(LOG_INFO, "setHardwareState <ERROR>");
             status->setStatusBar(StatusControl::StatusBarState::ERROR);
@@ -85,6 +306,7 @@ void MessageLoop::setHardwareState(const SystemHardwareStateChanged &data) {
         case SystemHardwareStateChanged::HardwareState::MANUEL:
             syslog(LOG_INFO, "setHardwareState <MANUEL>");
             status->setStatusBar(StatusControl::StatusBarState::MANUEL);
+            currentScene = SceneTable::NONE;
             eclctr->stopEclipse();
 //            setAmbientLight();
             break;
@@ -92,14 +314,15 @@ void MessageLoop::setHardwareState(const SystemHardwareStateChanged &data) {
         case SystemHardwareStateChanged::HardwareState::AUTOMATIC:
             syslog(LOG_INFO, "setHardwareState <AUTOMATIC>");
             status->setStatusBar(StatusControl::StatusBarState::AUTOMATIC);
+            currentScene = SceneTable::NONE;
             eclctr->startEclipse();
 //            setAmbientLight();
             break;
     }
 }
 
-void MessageLoop::setError(const ClientError &data) {
-    syslog(LOG_INFO, "ErrorId <%s> %s", data.errorId.c_str(), data.additionalMsg.c_str());
+void MessageLoop::setError(const char *errorId, const char *additionalMsg) {
+    syslog(LOG_INFO, "ErrorId <%s> %s", errorId, additionalMsg);
 }
 
 void MessageLoop::setAmbience(const EnvSetAmbience &data) {
@@ -107,6 +330,7 @@ void MessageLoop::setAmbience(const EnvSetAmbience &data) {
         syslog(LOG_WARNING, "setAmbience: automatic is on!");
         return;
     }
+    currentScene = SceneTable::NONE;
 
     if(data.curtainUp == ToggleState::ON) {
 //        eclctr->curtainUp();
@@ -121,14 +345,91 @@ void MessageLoop::setAmbience(const EnvSetAmbience &data) {
     }
 }
 
+void MessageLoop::setSyncedEffect(const Name &effect) {
+    if(!sync || !sync->isSynced()) {
+        syslog(LOG_WARNING, "effect <%s>: clock not synchronised, started here only", effect.c_str());
+        setEffect(effect);
+        return;
+    }
+    auto at = sync->referenceNow() + std::chrono::nanoseconds{sync->getLead()}.count();
+    if(endpoint) {
+        HeapGuard::Exempt exempt;
+        endpoint->sendMsg(EnvSyncedEffect{sync->getNode(), std::string{effect.view()}, at});
+    }
+    setEffect(effect, sync->toLocal(at));
+}
+
+void MessageLoop::setEffect(const Name &effect, Clock::TimePoint at) {
+    // <sound> starts a loop / plays a one shot, <sound>.off stops a loop, quiet stops all loops
+    if(!sound) {
+        syslog(LOG_WARNING, "effect <%s> not supported, no sound engine", effect.c_str());
+        return;
+    }
+    currentScene = SceneTable::NONE;
+    if(effect == "quiet") {
+        sound->stopAll();
+        return;
+    }
+    auto dot = effect.view().find('.');
+    SoundEngine::Sound s;
+    if(!SoundEngine::parse(effect.view().substr(0, dot), s)) {
+        syslog(LOG_WARNING, "effect <%s> not supported", effect.c_str());
+        return;
+    }
+    if(dot == std::string_view::npos) {
+        if(at != Clock::TimePoint{} && at < clock->now()) {
+            syslog(LOG_WARNING, "effect <%s> late by %lld ms", effect.c_str(), static_cast<long long>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(clock->now() - at).count()
+            ));
+        }
+        sound->start(s, at);
+    } else if(effect.view().substr(dot) == ".off") {
+        sound->stop(s);
+    } else {
+        syslog(LOG_WARNING, "effect <%s> not supported", effect.c_str());
+    }
+}
+
+void MessageLoop::setScene(const Name &name) {
+    std::size_t idx;
+    if(!scenes || !scenes->find(name, idx)) {
+        syslog(LOG_WARNING, "scene <%s> not defined", name.c_str());
+        return;
+    }
+    syslog(LOG_INFO, "setScene <%s>", name.c_str());
+
+    const auto &delta = scenes->delta(currentScene, idx);
+    currentScene = idx;
+
+    auto level = [&delta](std::uint32_t bit) -> std::optional<bool> {
+        if(!(delta.mask & bit)) {
+            return std::nullopt;
+        }
+        return (delta.levels & bit) != 0;
+    };
+    if(delta.mask & (SceneTable::CURTAIN_DOWN | SceneTable::MAIN_LIGHT)) {
+        eclctr->applyScene(level(SceneTable::CURTAIN_DOWN), level(SceneTable::MAIN_LIGHT));
+    }
+
+    auto loops = delta.mask >> SceneTable::SOUND_SHIFT;
+    if(loops && sound) {
+        auto on = delta.levels >> SceneTable::SOUND_SHIFT;
+        sound->setLoops(on, loops & ~on);
+    }
+}
+
 void MessageLoop::shutdown() {
     syslog(LOG_INFO, "shutdown");
-    execl("/usr/local/bin/moba-shutdown", "moba-shutdown", (char *)NULL);
+    if(shutdownControl) {
+        shutdownControl->request(ShutdownControl::Action::HALT, "ClientShutdown");
+    }
 }
 
 void MessageLoop::reboot() {
     syslog(LOG_INFO, "reboot");
-    execl("/usr/local/bin/moba-shutdown", "moba-shutdown", "-r", (char *)NULL);
+    if(shutdownControl) {
+        shutdownControl->request(ShutdownControl::Action::REBOOT, "ClientReset");
+    }
 }
 
 
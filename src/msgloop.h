@@ -20,22 +20,106 @@
 
 #pragma once
 
+#include <atomic>
+#include <functional>
+#include <string_view>
+#include <thread>
+
 #include "moba/endpoint.h"
 #include "moba/systemmessages.h"
 #include "moba/clientmessages.h"
 #include "moba/environmentmessages.h"
 #include "statuscontrol.h"
 #include "eclipsecontrol.h"
+#include "fixedstring.h"
+#include "localchannel.h"
+#include "msgscheduler.h"
+#include "scenetable.h"
+#include "clock.h"
+#include "clocksync.h"
+#include "debouncecalibration.h"
+#include "shutdowncontrol.h"
+#include "soundengine.h"
+#include "watchdog.h"
 
 class MessageLoop {
 public:
-    MessageLoop(EndpointPtr endpoint, StatusControlPtr status, EclipseControlPtr eclctr, BridgePtr bridge);
+    // scene and effect names, no longer than a local command carries
+    using Name = FixedString<LocalCommand::NAME_SIZE>;
+
+    /**
+     * What the daemon adds; any of them may be null (simulation, benchmarks),
+     * the commands for it are ignored then.
+     */
+    struct Options {
+        LocalChannelPtr local;
+        ShutdownControlPtr shutdown;
+        SoundEnginePtr sound;
+        SceneTablePtr scenes;
+        DebounceCalibrationPtr calibration;
+        ClockSyncPtr sync;
+        // handlers queued at most, see MessageScheduler
+        std::size_t jobs{256};
+    };
+
+    MessageLoop(
+        EndpointPtr endpoint, StatusControlPtr status, EclipseControlPtr eclctr, BridgePtr bridge,
+        ClockPtr clock, WatchdogPtr watchdog, const Options &options
+    );
+    ~MessageLoop();
 
     MessageLoop(const MessageLoop&) = delete;
     MessageLoop& operator=(const MessageLoop&) = delete;
 
+    /**
+     * Starts the dispatch thread and, with a local channel, its thread.
+     */
+    void start();
+
+    /**
+     * Runs run() in the receive thread.
+     * @param disconnect called by stop() to unblock the read from the server
+     */
+    void startReceiving(std::function<void()> disconnect);
+
+    /**
+     * Stops and joins the threads started by start() and startReceiving().
+     */
+    void stop();
+
+    /**
+     * Receives messages from the server until stop(), reconnects on errors.
+     */
     void run();
 
+    /**
+     * Entry points for inbound commands, also used by the simulation to feed
+     * the daemon without an endpoint. They only queue, the handlers run
+     * during dispatch.
+     */
+    void enqueueHardwareState(SystemHardwareStateChanged::HardwareState state);
+    void enqueueAmbience(ToggleState curtainUp, ToggleState mainLightOn);
+    void enqueueLocal(const LocalCommand &cmd);
+    void enqueueScene(std::string_view name);
+
+    /**
+     * An effect started on this and all other synchronised nodes lead ahead.
+     */
+    void enqueueSyncedEffect(std::string_view effect);
+
+    /**
+     * Runs all queued handlers on the calling thread (simulation only, the
+     * daemon dispatches in its own thread).
+     */
+    void dispatchPending();
+
+    /**
+     * Handlers dropped because all job slots were taken.
+     */
+    std::size_t rejectedJobs() const {
+        return scheduler.rejected();
+    }
+
 protected:
     struct AmbientLightData {
         int red;
@@ -44,9 +128,23 @@ protected:
         int white;
     };
 
-    void setHardwareState(const SystemHardwareStateChanged &data);
-    void setError(const ClientError &data);
+    void setHardwareState(SystemHardwareStateChanged::HardwareState state);
+    void setError(const char *errorId, const char *additionalMsg);
     void setAmbience(const EnvSetAmbience &data);
+    /**
+     * @param at start of a sound, as soon as possible by default
+     */
+    void setEffect(const Name &effect, Clock::TimePoint at = Clock::TimePoint{});
+    void setSyncedEffect(const Name &effect);
+
+    /**
+     * Applies the delta from the current scene as one curtain / light command
+     * and one sound command, so all outputs change together.
+     */
+    void setScene(const Name &name);
+
+    void dispatchControl();
+    void localChannelControl();
 
 
 /*
@@ -64,12 +162,31 @@ protected:
     bool automatic{false};
     bool emergency{false};
     bool standby{false};
-    bool closing{false};
+    std::atomic<bool> closing{false};
 
     EndpointPtr endpoint;
     StatusControlPtr status;
     EclipseControlPtr eclctr;
     BridgePtr bridge;
+    LocalChannelPtr local;
+    ClockPtr clock;
+    ShutdownControlPtr shutdownControl;
+    SoundEnginePtr sound;
+    SceneTablePtr scenes;
+    DebounceCalibrationPtr calibration;
+    ClockSyncPtr sync;
+    Watchdog::HeartbeatPtr dispatchHeartbeat;
+
+    // dispatch thread only; reset by every other command touching the same outputs
+    std::size_t currentScene{SceneTable::NONE};
+
+    std::thread dispatchThread;
+    std::thread localChannelThread;
+    std::thread receiveThread;
+    std::function<void()> disconnect;
+
+    // all handlers run in the dispatch thread, ordered by priority
+    MessageScheduler scheduler;
 
     AmbientLightData ambientLightData;
 };
@@ -0,0 +1,140 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "msgscheduler.h"
+
+#include <algorithm>
+#include <utility>
+
+MessageScheduler::MessageScheduler(ClockPtr clock, std::size_t capacity):
+clock{clock}, slots(std::max<std::size_t>(capacity, 1)), safety{slots.size()}, control{slots.size()}, cosmetic{slots.size()} {
+    freeSlots.reserve(slots.size());
+    for(std::size_t i = slots.size(); i > 0; --i) {
+        freeSlots.push_back(i - 1);
+    }
+}
+
+bool MessageScheduler::push(Lane lane, Job job) {
+    {
+        std::lock_guard<std::mutex> l{m};
+        std::size_t idx;
+        if(!acquire(lane, idx)) {
+            return false;
+        }
+        slots[idx].job = std::move(job);
+        slots[idx].queued = clock->now();
+        if(lane == Lane::SAFETY) {
+            safety.push(idx);
+        } else {
+            control.push(idx);
+        }
+    }
+    cv.notify_one();
+    return true;
+}
+
+bool MessageScheduler::pushCosmetic(std::string_view target, Job job) {
+    {
+        std::lock_guard<std::mutex> l{m};
+        // a handful of targets at most, a scan is cheaper than any index
+        for(std::size_t i = 0; i < cosmetic.size(); ++i) {
+            auto &slot = slots[cosmetic[i]];
+            if(slot.target == target) {
+                slot.job = std::move(job);
+                ++collapsedJobs;
+                return true;
+            }
+        }
+        std::size_t idx;
+        if(!acquire(Lane::COSMETIC, idx)) {
+            return false;
+        }
+        slots[idx].job = std::move(job);
+        slots[idx].target = Target{target};
+        cosmetic.push(idx);
+    }
+    cv.notify_one();
+    return true;
+}
+
+bool MessageScheduler::dispatchNext(std::chrono::milliseconds timeout) {
+    Job job;
+    {
+        std::unique_lock<std::mutex> l{m};
+        if(!cv.wait_for(l, timeout, [this, &job]{return popNext(job);})) {
+            return false;
+        }
+    }
+    job();
+    return true;
+}
+
+Clock::Duration MessageScheduler::maxSafetyLatency() const {
+    std::lock_guard<std::mutex> l{m};
+    return safetyLatency;
+}
+
+std::size_t MessageScheduler::collapsed() const {
+    std::lock_guard<std::mutex> l{m};
+    return collapsedJobs;
+}
+
+std::size_t MessageScheduler::rejected() const {
+    std::lock_guard<std::mutex> l{m};
+    return rejectedJobs;
+}
+
+bool MessageScheduler::acquire(Lane lane, std::size_t &idx) {
+    if(freeSlots.empty() && lane == Lane::SAFETY && !cosmetic.empty()) {
+        // ambience is resent anyway, a lost hardware state is not
+        release(cosmetic.pop());
+        ++rejectedJobs;
+    }
+    if(freeSlots.empty()) {
+        ++rejectedJobs;
+        return false;
+    }
+    idx = freeSlots.back();
+    freeSlots.pop_back();
+    return true;
+}
+
+void MessageScheduler::release(std::size_t idx) {
+    slots[idx].job.reset();
+    slots[idx].target = Target{};
+    freeSlots.push_back(idx);
+}
+
+bool MessageScheduler::popNext(Job &job) {
+    std::size_t idx;
+    if(!safety.empty()) {
+        idx = safety.pop();
+        safetyLatency = std::max(safetyLatency, clock->now() - slots[idx].queued);
+    } else if(!control.empty()) {
+        idx = control.pop();
+    } else if(!cosmetic.empty()) {
+        idx = cosmetic.pop();
+    } else {
+        return false;
+    }
+    job = std::move(slots[idx].job);
+    release(idx);
+    return true;
+}
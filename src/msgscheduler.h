@@ -0,0 +1,158 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "clock.h"
+#include "fixedstring.h"
+#include "inplacefunction.h"
+
+/**
+ * Inbound work split into priority lanes. The dispatcher always drains a
+ * higher lane completely before it looks at a lower one, so a safety message
+ * waits at most for the one job currently running, no matter how many
+ * cosmetic messages are queued.
+ *
+ * Cosmetic jobs are keyed by their target: a newer job for the same target
+ * replaces the queued one (last writer wins), so the cosmetic lane never holds
+ * more than one job per target.
+ *
+ * Jobs live in capacity slots allocated up front, a slot is free again as soon
+ * as its job ran. With all slots taken a safety job evicts the oldest cosmetic
+ * one, any other job is rejected.
+ */
+class MessageScheduler final {
+public:
+    enum class Lane {
+        SAFETY   = 0,  // hardware state, shutdown, reset
+        CONTROL  = 1,  // errors, curtain toggles, everything not collapsible
+        COSMETIC = 2,  // ambience, effects
+    };
+
+    // the biggest capture of any handler
+    static constexpr std::size_t JOB_SIZE = 192;
+
+    using Job = InplaceFunction<JOB_SIZE>;
+    using Target = FixedString<48>;
+
+    /**
+     * clock: queue latency is measured on it
+     */
+    explicit MessageScheduler(ClockPtr clock, std::size_t capacity = 256);
+
+    MessageScheduler(const MessageScheduler&) = delete;
+    MessageScheduler& operator=(const MessageScheduler&) = delete;
+
+    /**
+     * @return false if there was no free slot, the job is dropped then
+     */
+    bool push(Lane lane, Job job);
+    bool pushCosmetic(std::string_view target, Job job);
+
+    /**
+     * Runs the job with the highest priority, waits up to timeout if
+     * there is none.
+     * @return false on timeout
+     */
+    bool dispatchNext(std::chrono::milliseconds timeout);
+
+    /**
+     * @return the worst time a safety job spent queued so far
+     */
+    Clock::Duration maxSafetyLatency() const;
+
+    std::size_t collapsed() const;
+
+    /**
+     * Jobs dropped or evicted for lack of slots.
+     */
+    std::size_t rejected() const;
+
+private:
+    struct Slot {
+        Job job;
+        Target target;
+        Clock::TimePoint queued;
+    };
+
+    /**
+     * Slot indices in arrival order, never more than capacity.
+     */
+    class Queue {
+    public:
+        explicit Queue(std::size_t capacity): items(capacity) {
+        }
+
+        bool empty() const {
+            return count == 0;
+        }
+
+        std::size_t size() const {
+            return count;
+        }
+
+        std::size_t operator[](std::size_t i) const {
+            return items[(head + i) % items.size()];
+        }
+
+        void push(std::size_t idx) {
+            items[(head + count++) % items.size()] = idx;
+        }
+
+        std::size_t pop() {
+            auto idx = items[head];
+            head = (head + 1) % items.size();
+            --count;
+            return idx;
+        }
+
+    private:
+        std::vector<std::size_t> items;
+        std::size_t head{0};
+        std::size_t count{0};
+    };
+
+    bool acquire(Lane lane, std::size_t &idx);
+    void release(std::size_t idx);
+    bool popNext(Job &job);
+
+    ClockPtr clock;
+
+    mutable std::mutex m;
+    std::condition_variable cv;
+
+    std::vector<Slot> slots;
+    std::vector<std::size_t> freeSlots;
+
+    Queue safety;
+    Queue control;
+    Queue cosmetic;
+
+    Clock::Duration safetyLatency{0};
+    std::size_t collapsedJobs{0};
+    std::size_t rejectedJobs{0};
+};
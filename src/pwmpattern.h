@@ -0,0 +1,222 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <string>
+
+#include "clock.h"
+
+/**
+ * Brightness of a PWM output over time, handed to the backend once and
+ * played there without any further call. A pattern is a short list of steps,
+ * each running linearly from one brightness to another (a constant step has
+ * both equal), played once with the last brightness held, or looped.
+ *
+ * Brightness is perceived brightness in permille; dutyAt() maps it to the
+ * duty cycle with gamma 2, so ramps look even to the eye.
+ */
+class PwmPattern final {
+public:
+    static constexpr std::uint16_t FULL = 1000;
+    static constexpr std::size_t MAX_STEPS = 4;
+
+    struct Step {
+        Clock::Duration duration;
+        std::uint16_t from;
+        std::uint16_t to;
+    };
+
+    constexpr PwmPattern() = default;
+
+    static constexpr PwmPattern level(std::uint16_t brightness) {
+        return PwmPattern{Kind::LEVEL, false, {Step{Clock::Duration::zero(), brightness, brightness}}};
+    }
+
+    /**
+     * on, then off, looped; a flash is a short on with a long off
+     */
+    static constexpr PwmPattern blink(Clock::Duration on, Clock::Duration off, std::uint16_t brightness = FULL) {
+        return PwmPattern{Kind::BLINK, true, {Step{on, brightness, brightness}, Step{off, 0, 0}}};
+    }
+
+    /**
+     * low up to high and back within period, looped
+     */
+    static constexpr PwmPattern breathe(Clock::Duration period, std::uint16_t low, std::uint16_t high) {
+        return PwmPattern{Kind::BREATHE, true, {Step{period / 2, low, high}, Step{period - period / 2, high, low}}};
+    }
+
+    /**
+     * from to to within duration, then held
+     */
+    static constexpr PwmPattern ramp(std::uint16_t from, std::uint16_t to, Clock::Duration duration) {
+        return PwmPattern{Kind::RAMP, false, {Step{duration, from, to}}};
+    }
+
+    static constexpr std::uint16_t toDuty(std::uint16_t brightness) {
+        return static_cast<std::uint16_t>((std::uint32_t{brightness} * brightness + FULL / 2) / FULL);
+    }
+
+    /**
+     * @param t since the pattern started
+     */
+    constexpr std::uint16_t brightnessAt(Clock::Duration t) const {
+        auto base = cycleStart(t);
+        for(std::size_t i = 0; i < count; ++i) {
+            const auto &s = steps[i];
+            if(t < base + s.duration) {
+                return static_cast<std::uint16_t>(s.from + (s.to - s.from) * ((t - base) * 1000 / s.duration) / 1000);
+            }
+            base += s.duration;
+        }
+        return steps[count - 1].to;
+    }
+
+    constexpr std::uint16_t dutyAt(Clock::Duration t) const {
+        return toDuty(brightnessAt(t));
+    }
+
+    /**
+     * When the brightness changes next after t (since the start), at the
+     * latest after rampStep while ramping; Clock::Duration::max() if it
+     * never changes again.
+     */
+    constexpr Clock::Duration nextChange(Clock::Duration t, Clock::Duration rampStep) const {
+        auto base = cycleStart(t);
+        for(std::size_t i = 0; i < count; ++i) {
+            const auto &s = steps[i];
+            auto end = base + s.duration;
+            if(t < end) {
+                return s.from == s.to ? end : std::min(t + rampStep, end);
+            }
+            base = end;
+        }
+        return Clock::Duration::max();
+    }
+
+    /**
+     * The brightness held at the end, the highest one of a looped pattern.
+     */
+    constexpr std::uint16_t settled() const {
+        if(!loop) {
+            return steps[count - 1].to;
+        }
+        std::uint16_t peak = 0;
+        for(std::size_t i = 0; i < count; ++i) {
+            peak = std::max({peak, steps[i].from, steps[i].to});
+        }
+        return peak;
+    }
+
+    /**
+     * e.g. "blink 725/750ms 1000", for traces
+     */
+    std::string describe() const {
+        auto ms = [](Clock::Duration d) {
+            return static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(d).count());
+        };
+        char buf[64];
+        switch(kind) {
+            case Kind::LEVEL:
+                std::snprintf(buf, sizeof(buf), "level %u", steps[0].to);
+                break;
+
+            case Kind::BLINK:
+                std::snprintf(buf, sizeof(buf), "blink %lld/%lldms %u", ms(steps[0].duration), ms(steps[1].duration), steps[0].to);
+                break;
+
+            case Kind::BREATHE:
+                std::snprintf(
+                    buf, sizeof(buf), "breathe %lldms %u..%u", ms(steps[0].duration + steps[1].duration), steps[0].from, steps[0].to
+                );
+                break;
+
+            case Kind::RAMP:
+                std::snprintf(buf, sizeof(buf), "ramp %u..%u %lldms", steps[0].from, steps[0].to, ms(steps[0].duration));
+                break;
+        }
+        return buf;
+    }
+
+    constexpr bool operator==(const PwmPattern &other) const {
+        if(kind != other.kind || loop != other.loop || count != other.count) {
+            return false;
+        }
+        for(std::size_t i = 0; i < count; ++i) {
+            const auto &a = steps[i];
+            const auto &b = other.steps[i];
+            if(a.duration != b.duration || a.from != b.from || a.to != b.to) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    enum class Kind: std::uint8_t {
+        LEVEL,
+        BLINK,
+        BREATHE,
+        RAMP,
+    };
+
+    constexpr PwmPattern(Kind kind, bool loop, std::initializer_list<Step> list): kind{kind}, loop{loop}, count{0} {
+        for(const auto &s: list) {
+            steps[count++] = s;
+        }
+    }
+
+    /**
+     * Start of the cycle t falls into, moves t into the first cycle.
+     */
+    constexpr Clock::Duration cycleStart(Clock::Duration t) const {
+        if(!loop) {
+            return Clock::Duration::zero();
+        }
+        Clock::Duration period{0};
+        for(std::size_t i = 0; i < count; ++i) {
+            period += steps[i].duration;
+        }
+        return period > Clock::Duration::zero() ? t - t % period : Clock::Duration::zero();
+    }
+
+    Kind kind{Kind::LEVEL};
+    bool loop{false};
+    std::array<Step, MAX_STEPS> steps{Step{Clock::Duration::zero(), 0, 0}};
+    std::size_t count{1};
+};
+
+// the status bar patterns
+static_assert(PwmPattern::blink(std::chrono::milliseconds{725}, std::chrono::milliseconds{750}).brightnessAt(
+    std::chrono::milliseconds{1475 + 700}) == PwmPattern::FULL);
+static_assert(PwmPattern::blink(std::chrono::milliseconds{725}, std::chrono::milliseconds{750}).brightnessAt(
+    std::chrono::milliseconds{1475 + 730}) == 0);
+static_assert(PwmPattern::breathe(std::chrono::milliseconds{3000}, 0, 1000).brightnessAt(std::chrono::milliseconds{4500}) == 1000);
+static_assert(PwmPattern::ramp(0, 1000, std::chrono::seconds{30}).dutyAt(std::chrono::seconds{15}) == 250);
+static_assert(PwmPattern::blink(std::chrono::milliseconds{25}, std::chrono::milliseconds{1450}).nextChange(
+    std::chrono::milliseconds{1475 + 10}, std::chrono::milliseconds{20}) == std::chrono::milliseconds{1475 + 25});
+static_assert(PwmPattern::level(400).nextChange(std::chrono::seconds{1}, std::chrono::milliseconds{20}) == Clock::Duration::max());
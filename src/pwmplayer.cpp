@@ -0,0 +1,84 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "pwmplayer.h"
+
+#include <utility>
+
+namespace {
+    // a new pattern wakes the thread anyway, this only bounds the sleep
+    constexpr std::chrono::seconds IDLE{1};
+}
+
+PwmPlayer::PwmPlayer(ClockPtr clock, Writer writer): clock{clock}, writer{std::move(writer)} {
+    playThread = clock->startThread([this]{run();});
+}
+
+PwmPlayer::~PwmPlayer() noexcept {
+    running = false;
+    clock->wake(alarm);
+    if(playThread.joinable()) {
+        playThread.join();
+    }
+}
+
+void PwmPlayer::play(int pin, const PwmPattern &pattern) {
+    {
+        std::lock_guard<std::mutex> l{m};
+        tracks[pin] = Track{pattern, clock->now(), 0, true, true};
+    }
+    clock->wake(alarm);
+}
+
+void PwmPlayer::run() {
+    std::array<std::pair<int, std::uint16_t>, 32> due;
+
+    while(running) {
+        std::size_t n = 0;
+        auto now = clock->now();
+        auto wakeAt = now + IDLE;
+        {
+            std::lock_guard<std::mutex> l{m};
+            for(int pin = 0; pin < 32; ++pin) {
+                auto &track = tracks[pin];
+                if(!track.active) {
+                    continue;
+                }
+                auto t = now - track.start;
+                auto duty = track.pattern.dutyAt(t);
+                if(duty != track.duty || track.fresh) {
+                    track.duty = duty;
+                    track.fresh = false;
+                    due[n++] = {pin, duty};
+                }
+                auto next = track.pattern.nextChange(t, RAMP_STEP);
+                if(next != Clock::Duration::max()) {
+                    wakeAt = std::min(wakeAt, track.start + next);
+                }
+            }
+        }
+        // outside the lock, the hardware may be slow
+        for(std::size_t i = 0; i < n; ++i) {
+            writer(due[i].first, due[i].second);
+        }
+        writeCount += n;
+        clock->sleepFor(wakeAt - clock->now(), alarm);
+    }
+}
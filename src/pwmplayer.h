@@ -0,0 +1,87 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "clock.h"
+#include "pwmpattern.h"
+
+/**
+ * Plays PwmPatterns on up to 32 pins from one thread for a backend whose PWM
+ * only takes a duty cycle: it sleeps until the next change of any pin and
+ * writes the changed duty cycles only. A constant pattern costs nothing once
+ * written, a blink two writes per period, a ramp one write per RAMP_STEP.
+ */
+class PwmPlayer final {
+public:
+    // permille duty cycle
+    using Writer = std::function<void(int pin, std::uint16_t duty)>;
+
+    static constexpr std::chrono::milliseconds RAMP_STEP{20};
+
+    PwmPlayer(ClockPtr clock, Writer writer);
+    ~PwmPlayer() noexcept;
+
+    PwmPlayer(const PwmPlayer&) = delete;
+    PwmPlayer& operator=(const PwmPlayer&) = delete;
+
+    /**
+     * From any thread, the pattern starts now.
+     */
+    void play(int pin, const PwmPattern &pattern);
+
+    /**
+     * Duty cycle writes so far.
+     */
+    std::uint64_t writes() const {
+        return writeCount;
+    }
+
+private:
+    struct Track {
+        PwmPattern pattern;
+        Clock::TimePoint start;
+        std::uint16_t duty;
+        bool active;
+        // not written yet
+        bool fresh;
+    };
+
+    void run();
+
+    ClockPtr clock;
+    Writer writer;
+
+    std::mutex m;
+    std::array<Track, 32> tracks{};
+    Clock::Alarm alarm;
+
+    std::atomic<std::uint64_t> writeCount{0};
+    std::atomic<bool> running{true};
+    std::thread playThread;
+};
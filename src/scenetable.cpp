@@ -0,0 +1,108 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "scenetable.h"
+
+#include <sstream>
+#include <syslog.h>
+
+SceneTable::SceneTable(moba::IniPtr ini) {
+    std::istringstream names{ini->getString("scenes", "names", "")};
+    for(std::string name; std::getline(names, name, ',');) {
+        if(name.empty()) {
+            continue;
+        }
+        if(scenes.size() == MAX_SCENES) {
+            syslog(LOG_ERR, "scene <%s> ignored, more than %zu scenes", name.c_str(), MAX_SCENES);
+            continue;
+        }
+        Delta full{0, 0};
+        if(compile(name, ini->getString("scenes", name, ""), full)) {
+            scenes.push_back(Scene{name, full});
+        }
+    }
+
+    // from a known scene only what differs: outputs the previous scene left alone or set otherwise
+    auto n = scenes.size();
+    deltas.resize((n + 1) * n);
+    for(std::size_t to = 0; to < n; ++to) {
+        const auto &target = scenes[to].full;
+        for(std::size_t from = 0; from < n; ++from) {
+            const auto &source = scenes[from].full;
+            auto same = source.mask & target.mask & ~(source.levels ^ target.levels);
+            auto mask = target.mask & ~same;
+            deltas[from * n + to] = Delta{mask, target.levels & mask};
+        }
+        deltas[n * n + to] = target;
+    }
+    syslog(LOG_INFO, "%zu scenes loaded", n);
+}
+
+bool SceneTable::find(std::string_view name, std::size_t &idx) const {
+    for(std::size_t i = 0; i < scenes.size(); ++i) {
+        if(scenes[i].name == name) {
+            idx = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SceneTable::compile(const std::string &name, const std::string &definition, Delta &delta) {
+    if(definition.empty()) {
+        syslog(LOG_ERR, "scene <%s> not defined", name.c_str());
+        return false;
+    }
+
+    std::istringstream items{definition};
+    for(std::string item; items >> item;) {
+        auto colon = item.find(':');
+        auto output = item.substr(0, colon);
+        auto level = colon == std::string::npos ? "" : item.substr(colon + 1);
+
+        std::uint32_t bit;
+        bool high;
+        SoundEngine::Sound sound;
+        if(output == "curtain" && (level == "up" || level == "down")) {
+            bit = CURTAIN_DOWN;
+            high = level == "down";
+        } else if(output == "light" && (level == "on" || level == "off")) {
+            bit = MAIN_LIGHT;
+            high = level == "on";
+        } else if(
+            SoundEngine::parse(output, sound) && sound != SoundEngine::Sound::THUNDER && (level == "on" || level == "off")
+        ) {
+            bit = soundBit(sound);
+            high = level == "on";
+        } else {
+            syslog(LOG_ERR, "scene <%s>: invalid item <%s>", name.c_str(), item.c_str());
+            return false;
+        }
+        if(delta.mask & bit) {
+            syslog(LOG_ERR, "scene <%s>: <%s> set twice", name.c_str(), output.c_str());
+            return false;
+        }
+        delta.mask |= bit;
+        if(high) {
+            delta.levels |= bit;
+        }
+    }
+    return true;
+}
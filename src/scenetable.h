@@ -0,0 +1,106 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <moba-common/ini.h>
+
+#include "soundengine.h"
+
+/**
+ * Named scenes from section [scenes], compiled once at load time into an
+ * output delta: a mask of the outputs the scene sets and their levels. The
+ * delta between any two scenes is precomputed as well, so switching scenes
+ * only touches what differs.
+ *
+ *   [scenes]
+ *   names=day,night
+ *   day=curtain:up light:on birds:on wind:off
+ *   night=curtain:down light:off birds:off wind:on
+ *
+ * Outputs: curtain (up|down), light (on|off) and the sound loops (on|off).
+ */
+class SceneTable final {
+public:
+    enum Output: std::uint32_t {
+        CURTAIN_DOWN = 1u << 0,
+        MAIN_LIGHT   = 1u << 1,
+        // bit SOUND_SHIFT + Sound
+        SOUND_SHIFT  = 2,
+    };
+
+    static constexpr std::size_t MAX_SCENES = 32;
+
+    // no scene applied, or the outputs changed since
+    static constexpr std::size_t NONE = MAX_SCENES;
+
+    struct Delta {
+        // outputs to set
+        std::uint32_t mask;
+        // their levels, 1: curtain down / on
+        std::uint32_t levels;
+    };
+
+    explicit SceneTable(moba::IniPtr ini);
+
+    SceneTable(const SceneTable&) = delete;
+    SceneTable& operator=(const SceneTable&) = delete;
+
+    static constexpr std::uint32_t soundBit(SoundEngine::Sound sound) {
+        return 1u << (SOUND_SHIFT + static_cast<std::uint32_t>(sound));
+    }
+
+    /**
+     * @return false if there is no such scene
+     */
+    bool find(std::string_view name, std::size_t &idx) const;
+
+    /**
+     * What has to change to get from scene from (or NONE) to scene to.
+     */
+    const Delta &delta(std::size_t from, std::size_t to) const {
+        return deltas[(from == NONE ? scenes.size() : from) * scenes.size() + to];
+    }
+
+    std::size_t size() const {
+        return scenes.size();
+    }
+
+private:
+    struct Scene {
+        std::string name;
+        Delta full;
+    };
+
+    bool compile(const std::string &name, const std::string &definition, Delta &delta);
+
+    std::vector<Scene> scenes;
+
+    // (scenes + 1) rows, the last one is from NONE
+    std::vector<Delta> deltas;
+};
+
+using SceneTablePtr = std::shared_ptr<SceneTable>;
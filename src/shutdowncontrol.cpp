@@ -0,0 +1,211 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "shutdowncontrol.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
+#include <syslog.h>
+#include <unistd.h>
+
+namespace {
+    const char *actionName(ShutdownControl::Action action) {
+        switch(action) {
+            case ShutdownControl::Action::EXIT:
+                return "EXIT";
+
+            case ShutdownControl::Action::HALT:
+                return "HALT";
+
+            case ShutdownControl::Action::REBOOT:
+                return "REBOOT";
+
+            default:
+                return "NONE";
+        }
+    }
+
+    double msSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    sigset_t shutdownSignals() {
+        sigset_t set;
+        sigemptyset(&set);
+        sigaddset(&set, SIGTERM);
+        sigaddset(&set, SIGINT);
+        return set;
+    }
+}
+
+ShutdownControl::ShutdownControl(BridgePtr bridge, moba::IniPtr ini): bridge{bridge} {
+    deadline = std::chrono::milliseconds{ini->getInt("shutdown", "deadline", 5000)};
+    helper = ini->getString("shutdown", "helper", "/usr/local/bin/moba-shutdown");
+
+    struct {
+        const char *key;
+        Bridge::PinOutputMapping pin;
+        int level;
+    } levels[] = {
+        {"status_green", Bridge::STATUS_GREEN, 0},
+        {"status_red",   Bridge::STATUS_RED,   1},
+        {"main_light",   Bridge::MAIN_LIGHT,   0},
+        {"curtain_on",   Bridge::CURTAIN_ON,   0},
+        {"curtain_dir",  Bridge::CURTAIN_DIR,  0},
+    };
+    std::uint32_t high = 0;
+    std::uint32_t low = 0;
+    for(const auto &l: levels) {
+        if(ini->getInt("park", l.key, l.level)) {
+            high |= Bridge::mask(l.pin);
+        } else {
+            low |= Bridge::mask(l.pin);
+        }
+    }
+    bridge->setParkLevels(high, low);
+
+    // inherited by every thread started afterwards, so only the signal thread receives them
+    auto set = shutdownSignals();
+    pthread_sigmask(SIG_BLOCK, &set, nullptr);
+    signalThread = std::thread{&ShutdownControl::signalControl, this};
+}
+
+ShutdownControl::~ShutdownControl() noexcept {
+    if(signalThread.joinable()) {
+        request(Action::EXIT, "destructor");
+        pthread_kill(signalThread.native_handle(), SIGTERM);
+        signalThread.join();
+    }
+}
+
+void ShutdownControl::request(Action action, const std::string &reason) {
+    {
+        std::lock_guard<std::mutex> l{m};
+        if(this->action != Action::NONE) {
+            return;
+        }
+        this->action = action;
+    }
+    syslog(LOG_NOTICE, "shutdown <%s> requested by <%s>", actionName(action), reason.c_str());
+    cv.notify_all();
+}
+
+void ShutdownControl::addPhase(const std::string &name, std::function<void()> phase) {
+    std::lock_guard<std::mutex> l{m};
+    phases.push_back(Phase{name, std::move(phase)});
+}
+
+void ShutdownControl::signalControl() {
+    auto set = shutdownSignals();
+    int sig;
+    while(sigwait(&set, &sig) != 0) {
+    }
+    request(Action::EXIT, strsignal(sig));
+}
+
+void ShutdownControl::run() {
+    Action action;
+    {
+        std::unique_lock<std::mutex> l{m};
+        cv.wait(l, [this]{return this->action != Action::NONE;});
+        action = this->action;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    bool clean = runPhases();
+
+    bridge->park();
+    syslog(LOG_NOTICE, "shutdown: outputs parked after %.1f ms", msSince(start));
+
+    if(clean) {
+        // wakes the signal thread, unless a signal has done that already
+        pthread_kill(signalThread.native_handle(), SIGTERM);
+        signalThread.join();
+    }
+
+    if(action == Action::HALT || action == Action::REBOOT) {
+        execHelper();
+    }
+    if(!clean) {
+        // threads are still running, destructors would wait for them
+        _exit(EXIT_FAILURE);
+    }
+}
+
+bool ShutdownControl::runPhases() {
+    struct Progress {
+        std::mutex m;
+        std::condition_variable cv;
+        std::size_t current{0};
+        bool done{false};
+    };
+
+    // shared, a worker past the deadline outlives this call
+    auto progress = std::make_shared<Progress>();
+
+    // phases run in a worker, so a hanging join cannot hold up the deadline
+    std::thread worker{[this, progress] {
+        auto total = std::chrono::steady_clock::now();
+        for(std::size_t i = 0; i < phases.size(); ++i) {
+            {
+                std::lock_guard<std::mutex> l{progress->m};
+                progress->current = i;
+            }
+            auto start = std::chrono::steady_clock::now();
+            try {
+                phases[i].fn();
+            } catch(const std::exception &e) {
+                syslog(LOG_ERR, "shutdown: phase <%s> failed <%s>", phases[i].name.c_str(), e.what());
+            }
+            syslog(LOG_NOTICE, "shutdown: phase <%s> took %.1f ms", phases[i].name.c_str(), msSince(start));
+        }
+        syslog(LOG_NOTICE, "shutdown: all phases done in %.1f ms", msSince(total));
+
+        std::lock_guard<std::mutex> l{progress->m};
+        progress->done = true;
+        progress->cv.notify_all();
+    }};
+
+    std::unique_lock<std::mutex> l{progress->m};
+    if(progress->cv.wait_for(l, deadline, [&progress]{return progress->done;})) {
+        l.unlock();
+        worker.join();
+        return true;
+    }
+    syslog(
+        LOG_CRIT, "shutdown: deadline of %lld ms exceeded in phase <%s>",
+        static_cast<long long>(deadline.count()), phases[progress->current].name.c_str()
+    );
+    worker.detach();
+    return false;
+}
+
+void ShutdownControl::execHelper() {
+    syslog(LOG_NOTICE, "shutdown: running <%s>", helper.c_str());
+    if(action == Action::REBOOT) {
+        execl(helper.c_str(), "moba-shutdown", "-r", (char *)NULL);
+    } else {
+        execl(helper.c_str(), "moba-shutdown", (char *)NULL);
+    }
+    syslog(LOG_CRIT, "shutdown: exec of <%s> failed <%s>", helper.c_str(), std::strerror(errno));
+}
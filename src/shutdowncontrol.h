@@ -0,0 +1,109 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <moba-common/ini.h>
+
+#include "bridge.h"
+
+/**
+ * Coordinated shutdown. Triggers (ClientShutdown, ClientReset, long button
+ * press, SIGTERM / SIGINT) only request it, the pipeline itself runs in the
+ * thread calling run(): all registered phases in order (stop the loops, save
+ * state, ...), then the outputs are parked. Phases have to finish within a
+ * hard deadline, otherwise the outputs are parked anyway and the process
+ * ends without waiting any longer. Afterwards the shutdown helper is run for
+ * HALT and REBOOT.
+ *
+ * Configurable in section [shutdown]:
+ *   deadline=<ms>
+ *   helper=<path>
+ * and the park level (0 / 1) of every output in section [park]:
+ *   status_green, status_red, main_light, curtain_on, curtain_dir
+ */
+class ShutdownControl final {
+public:
+    enum class Action {
+        NONE   = 0,
+        EXIT   = 1,  // leave the daemon only (SIGTERM, e.g. systemctl stop)
+        HALT   = 2,
+        REBOOT = 3,
+    };
+
+    /**
+     * Blocks SIGTERM and SIGINT and starts the signal thread, so it has to be
+     * constructed before any other thread is started.
+     */
+    ShutdownControl(BridgePtr bridge, moba::IniPtr ini);
+    ~ShutdownControl() noexcept;
+
+    ShutdownControl(const ShutdownControl&) = delete;
+    ShutdownControl& operator=(const ShutdownControl&) = delete;
+
+    /**
+     * Thread safe and non blocking, the first request wins.
+     */
+    void request(Action action, const std::string &reason);
+
+    /**
+     * Phases run in the order of registration.
+     */
+    void addPhase(const std::string &name, std::function<void()> phase);
+
+    /**
+     * Waits for a request, runs the pipeline and, for HALT and REBOOT, execs
+     * the shutdown helper. Only returns on EXIT with all phases done in time.
+     */
+    void run();
+
+private:
+    struct Phase {
+        std::string name;
+        std::function<void()> fn;
+    };
+
+    void signalControl();
+    bool runPhases();
+    void execHelper();
+
+    BridgePtr bridge;
+
+    std::chrono::milliseconds deadline;
+    std::string helper;
+
+    std::mutex m;
+    std::condition_variable cv;
+    Action action{Action::NONE};
+    std::vector<Phase> phases;
+
+    std::thread signalThread;
+};
+
+using ShutdownControlPtr = std::shared_ptr<ShutdownControl>;
@@ -0,0 +1,200 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "simbackend.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+    // splitmix64, deterministic noise for the chatter
+    std::uint64_t mix(std::uint64_t x) {
+        x += 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+}
+
+SimulatedBackend::SimulatedBackend(ClockPtr clock): clock{clock} {
+}
+
+void SimulatedBackend::setupOutput(int pin) {
+    std::lock_guard<std::mutex> l{m};
+    outputMask |= 1u << pin;
+}
+
+void SimulatedBackend::setupInput(int pin) {
+    std::lock_guard<std::mutex> l{m};
+    outputMask &= ~(1u << pin);
+}
+
+void SimulatedBackend::write(std::uint32_t highMask, std::uint32_t lowMask) {
+    std::uint32_t risen;
+    std::uint32_t fallen;
+    WriteHook h;
+    {
+        std::lock_guard<std::mutex> l{m};
+        auto now = clock->now();
+        // a relay due to switch does so before its coil drops
+        updateRelay(now);
+
+        highMask &= outputMask & ~lowMask;
+        lowMask &= outputMask;
+
+        auto next = (outputs | highMask) & ~lowMask;
+        risen = next & ~outputs;
+        fallen = outputs & ~next;
+        outputs = next;
+
+        if(relay.output >= 0 && (risen & (1u << relay.output))) {
+            relay.energised = now;
+            relay.switched = false;
+            updateRelay(now);
+        }
+        for(int pin = 0; pin < 32; ++pin) {
+            if((risen | fallen) & (1u << pin)) {
+                transitions.push_back({now, pin, static_cast<bool>(risen & (1u << pin))});
+            }
+        }
+        h = hook;
+    }
+    if(h && (risen | fallen)) {
+        h(risen, fallen);
+    }
+}
+
+bool SimulatedBackend::read(int pin) {
+    std::lock_guard<std::mutex> l{m};
+    updateRelay(clock->now());
+    bool level = inputs & (1u << pin);
+    const auto &b = bounces[pin];
+    auto since = clock->now() - b.changedAt;
+    if(since < b.length) {
+        // a new random level every 5 µs
+        auto slot = static_cast<std::uint64_t>(since / std::chrono::microseconds{5});
+        level ^= mix((std::uint64_t{b.edges} << 32) ^ slot) & 1;
+    }
+    return level;
+}
+
+void SimulatedBackend::setInput(int pin, bool level) {
+    std::lock_guard<std::mutex> l{m};
+    setInputLocked(pin, level, clock->now());
+}
+
+void SimulatedBackend::setInputLocked(int pin, bool level, Clock::TimePoint at) {
+    auto &b = bounces[pin];
+    if(b.duration > Clock::Duration::zero() && static_cast<bool>(inputs & (1u << pin)) != level) {
+        ++b.edges;
+        b.changedAt = at;
+        b.length = b.duration / 2 + b.duration * static_cast<Clock::Duration::rep>(mix(b.edges) % 1024) / 2048;
+    }
+    if(level) {
+        inputs |= 1u << pin;
+    } else {
+        inputs &= ~(1u << pin);
+    }
+}
+
+void SimulatedBackend::setBounce(int pin, Clock::Duration duration) {
+    std::lock_guard<std::mutex> l{m};
+    bounces[pin].duration = duration;
+}
+
+void SimulatedBackend::setImpulseRelay(int output, int input, Clock::Duration response, Clock::Duration lag) {
+    std::lock_guard<std::mutex> l{m};
+    relay.output = output;
+    relay.input = input;
+    relay.response = response;
+    relay.lag = lag;
+}
+
+void SimulatedBackend::setRelayStuck(bool stuck) {
+    std::lock_guard<std::mutex> l{m};
+    relay.stuck = stuck;
+}
+
+void SimulatedBackend::updateRelay(Clock::TimePoint now) {
+    if(relay.output >= 0 && !relay.stuck && !relay.switched && (outputs & (1u << relay.output))) {
+        auto at = relay.energised + relay.response;
+        if(now >= at) {
+            relay.switched = true;
+            if(relay.feedbackPending) {
+                // switched again before the contact followed the last switch
+                setInputLocked(relay.input, !(inputs & (1u << relay.input)), at);
+            }
+            relay.feedbackPending = true;
+            relay.feedbackAt = at + relay.lag;
+        }
+    }
+    if(relay.feedbackPending && now >= relay.feedbackAt) {
+        relay.feedbackPending = false;
+        setInputLocked(relay.input, !(inputs & (1u << relay.input)), relay.feedbackAt);
+    }
+}
+
+void SimulatedBackend::setWriteHook(WriteHook hook) {
+    std::lock_guard<std::mutex> l{m};
+    this->hook = hook;
+}
+
+std::uint32_t SimulatedBackend::getOutputs() {
+    std::lock_guard<std::mutex> l{m};
+    return outputs;
+}
+
+std::vector<SimulatedBackend::Transition> SimulatedBackend::takeTransitions() {
+    std::lock_guard<std::mutex> l{m};
+    return std::exchange(transitions, {});
+}
+
+GpioBackend::Pwm SimulatedBackend::setupPwm(int pin) {
+    std::lock_guard<std::mutex> l{m};
+    if(!(outputMask & (1u << pin))) {
+        return Pwm::NONE;
+    }
+    // like a pin switched to its PWM function, write() does not reach it any more
+    outputMask &= ~(1u << pin);
+    pwmMask |= 1u << pin;
+    return Pwm::HARDWARE;
+}
+
+void SimulatedBackend::playPwm(int pin, const PwmPattern &pattern) {
+    std::lock_guard<std::mutex> l{m};
+    if(pwmMask & (1u << pin)) {
+        pwmTimeline.push_back({clock->now(), pin, pattern});
+    }
+}
+
+std::uint16_t SimulatedBackend::getDuty(int pin, Clock::TimePoint time) {
+    std::lock_guard<std::mutex> l{m};
+    auto iter = std::find_if(pwmTimeline.rbegin(), pwmTimeline.rend(), [pin, time](const PwmChange &c) {
+        return c.pin == pin && c.time <= time;
+    });
+    return iter == pwmTimeline.rend() ? 0 : iter->pattern.dutyAt(time - iter->time);
+}
+
+std::vector<SimulatedBackend::PwmChange> SimulatedBackend::takePwmChanges() {
+    std::lock_guard<std::mutex> l{m};
+    std::vector<PwmChange> changes{pwmTimeline.begin() + pwmTaken, pwmTimeline.end()};
+    pwmTaken = pwmTimeline.size();
+    return changes;
+}
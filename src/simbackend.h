@@ -0,0 +1,152 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "clock.h"
+#include "gpiobackend.h"
+
+/**
+ * Gpio pins in memory. Every output change is recorded with the time of
+ * the given clock. Inputs are set from outside (simulation driver, benchmark).
+ * Every output can be set up for PWM, it then behaves like a hardware channel:
+ * the pattern is recorded and evaluated on request, so duty cycle timelines
+ * can be checked at any point in time.
+ */
+class SimulatedBackend final: public GpioBackend {
+public:
+    struct Transition {
+        Clock::TimePoint time;
+        int pin;
+        bool level;
+    };
+
+    struct PwmChange {
+        Clock::TimePoint time;
+        int pin;
+        PwmPattern pattern;
+    };
+
+    /**
+     * Called after each write with the pins that actually changed,
+     * e.g. to model a relay feeding back into an input.
+     */
+    using WriteHook = std::function<void(std::uint32_t risen, std::uint32_t fallen)>;
+
+    explicit SimulatedBackend(ClockPtr clock);
+
+    SimulatedBackend(const SimulatedBackend&) = delete;
+    SimulatedBackend& operator=(const SimulatedBackend&) = delete;
+
+    void setupOutput(int pin) override;
+    void setupInput(int pin) override;
+
+    void write(std::uint32_t highMask, std::uint32_t lowMask) override;
+    bool read(int pin) override;
+
+    Pwm setupPwm(int pin) override;
+    void playPwm(int pin, const PwmPattern &pattern) override;
+
+    /**
+     * Permille duty cycle of a PWM pin at time, per the pattern playing then.
+     * A time before the first pattern gives 0.
+     */
+    std::uint16_t getDuty(int pin, Clock::TimePoint time);
+
+    void setInput(int pin, bool level);
+
+    /**
+     * From now on every level change of input pin chatters for up to
+     * duration (half to all of it, varying per edge) before it settles.
+     */
+    void setBounce(int pin, Clock::Duration duration);
+
+    /**
+     * An impulse relay on output: once the output was high for response,
+     * the relay switches and toggles input (feedback contact) lag later,
+     * whether the output is still high or not. A stuck relay never switches.
+     */
+    void setImpulseRelay(int output, int input, Clock::Duration response, Clock::Duration lag = Clock::Duration::zero());
+    void setRelayStuck(bool stuck);
+
+    void setWriteHook(WriteHook hook);
+
+    std::uint32_t getOutputs();
+
+    /**
+     * Hands out the recorded transitions and starts a new record.
+     */
+    std::vector<Transition> takeTransitions();
+
+    /**
+     * Hands out the patterns played since the last call.
+     */
+    std::vector<PwmChange> takePwmChanges();
+
+private:
+    void setInputLocked(int pin, bool level, Clock::TimePoint at);
+    void updateRelay(Clock::TimePoint now);
+
+    ClockPtr clock;
+    WriteHook hook;
+
+    std::mutex m;
+    std::uint32_t outputMask{0};
+    std::uint32_t outputs{0};
+    // inputs idle high (pull up)
+    std::uint32_t inputs{~0u};
+
+    struct Bounce {
+        Clock::Duration duration{};
+        // of the current edge
+        Clock::Duration length{};
+        Clock::TimePoint changedAt{};
+        std::uint32_t edges{0};
+    };
+    Bounce bounces[32];
+
+    struct Relay {
+        int output{-1};
+        int input{-1};
+        Clock::Duration response{};
+        Clock::Duration lag{};
+        bool stuck{false};
+        Clock::TimePoint energised{};
+        // for the current pulse
+        bool switched{false};
+        // switched, the feedback contact follows at feedbackAt
+        bool feedbackPending{false};
+        Clock::TimePoint feedbackAt{};
+    };
+    Relay relay;
+
+    std::vector<Transition> transitions;
+
+    std::uint32_t pwmMask{0};
+    // every pattern ever played, by time; getDuty() looks back into it
+    std::vector<PwmChange> pwmTimeline;
+    std::size_t pwmTaken{0};
+};
+
+using SimulatedBackendPtr = std::shared_ptr<SimulatedBackend>;
@@ -0,0 +1,111 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "soundclip.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    std::uint32_t le32(const unsigned char *p) {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+    }
+
+    std::uint16_t le16(const unsigned char *p) {
+        return p[0] | (p[1] << 8);
+    }
+}
+
+SoundClip::SoundClip(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd == -1) {
+        throw std::runtime_error{"unable to open <" + path + ">: " + std::strerror(errno)};
+    }
+    struct stat st;
+    if(fstat(fd, &st) == -1 || st.st_size == 0) {
+        close(fd);
+        throw std::runtime_error{"unable to stat <" + path + "> or file is empty"};
+    }
+    mapSize = static_cast<std::size_t>(st.st_size);
+    map = mmap(nullptr, mapSize, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED) {
+        map = nullptr;
+        throw std::runtime_error{"unable to map <" + path + ">: " + std::strerror(errno)};
+    }
+    madvise(map, mapSize, MADV_WILLNEED);
+
+    try {
+        parse(path);
+    } catch(...) {
+        munmap(map, mapSize);
+        throw;
+    }
+}
+
+SoundClip::~SoundClip() noexcept {
+    munmap(map, mapSize);
+}
+
+void SoundClip::parse(const std::string &path) {
+    auto p = static_cast<const unsigned char*>(map);
+    auto end = p + mapSize;
+
+    if(mapSize < 12 || std::memcmp(p, "RIFF", 4) || std::memcmp(p + 8, "WAVE", 4)) {
+        throw std::runtime_error{"<" + path + "> is not a wave file"};
+    }
+    p += 12;
+
+    bool fmt = false;
+    while(end - p >= 8) {
+        auto size = le32(p + 4);
+        auto body = p + 8;
+        if(size > static_cast<std::size_t>(end - body)) {
+            // truncated files are common, play what is there
+            size = end - body;
+        }
+        if(!std::memcmp(p, "fmt ", 4) && size >= 16) {
+            if(le16(body) != 1 || le16(body + 14) != 16) {
+                throw std::runtime_error{"<" + path + "> is not 16 bit PCM"};
+            }
+            channelCount = le16(body + 2);
+            sampleRate = le32(body + 4);
+            if(channelCount != 1 && channelCount != 2) {
+                throw std::runtime_error{"<" + path + "> has neither one nor two channels"};
+            }
+            fmt = true;
+        } else if(!std::memcmp(p, "data", 4)) {
+            if(!fmt) {
+                throw std::runtime_error{"<" + path + "> data chunk without format"};
+            }
+            // chunks are padded to even offsets, so the samples are aligned
+            samples = reinterpret_cast<const std::int16_t*>(body);
+            frameCount = size / (2 * channelCount);
+            return;
+        }
+        p = body + size + (size & 1);
+    }
+    throw std::runtime_error{"<" + path + "> has no data chunk"};
+}
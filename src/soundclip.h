@@ -0,0 +1,74 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * 16 bit PCM wave file (mono or stereo), memory mapped and prefaulted on
+ * load, so the mixer never waits for the disk or decodes anything.
+ */
+class SoundClip final {
+public:
+    /**
+     * @throws std::runtime_error if the file can't be mapped or isn't a 16 bit PCM wave file
+     */
+    explicit SoundClip(const std::string &path);
+    ~SoundClip() noexcept;
+
+    SoundClip(const SoundClip&) = delete;
+    SoundClip& operator=(const SoundClip&) = delete;
+
+    /**
+     * Interleaved samples, channels() per frame.
+     */
+    const std::int16_t *data() const {
+        return samples;
+    }
+
+    std::size_t frames() const {
+        return frameCount;
+    }
+
+    unsigned int channels() const {
+        return channelCount;
+    }
+
+    unsigned int rate() const {
+        return sampleRate;
+    }
+
+private:
+    void parse(const std::string &path);
+
+    void *map{nullptr};
+    std::size_t mapSize{0};
+
+    const std::int16_t *samples{nullptr};
+    std::size_t frameCount{0};
+    unsigned int channelCount{0};
+    unsigned int sampleRate{0};
+};
+
+using SoundClipPtr = std::shared_ptr<SoundClip>;
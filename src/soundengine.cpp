@@ -0,0 +1,303 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "soundengine.h"
+
+#include <algorithm>
+#include <syslog.h>
+#include <utility>
+
+namespace {
+    struct SoundInfo {
+        const char *name;
+        bool loop;
+    };
+
+    constexpr SoundInfo SOUNDS[SoundEngine::SOUND_COUNT] = {
+        {"rain",    true},
+        {"birds",   true},
+        {"wind",    true},
+        {"thunder", false},
+    };
+}
+
+SoundEngine::SoundEngine(SoundSinkPtr sink, moba::IniPtr ini, ClockPtr clock): sink{sink}, clock{clock} {
+    period = static_cast<std::size_t>(std::clamp(ini->getInt("sound", "period", 256), 32, 8192));
+    rate = sink->rate();
+    volume = ini->getInt("sound", "volume", 100) / 100.0f;
+    fadeFrames = static_cast<std::uint32_t>(std::int64_t{std::max(ini->getInt("sound", "fade", 2000), 0)} * rate / 1000);
+
+    for(std::size_t i = 0; i < SOUND_COUNT; ++i) {
+        auto path = ini->getString("sound", SOUNDS[i].name, "");
+        if(path.empty()) {
+            continue;
+        }
+        try {
+            auto clip = std::make_shared<SoundClip>(path);
+            if(clip->rate() != rate) {
+                syslog(LOG_WARNING, "sound <%s>: rate %u Hz, expected %u Hz", SOUNDS[i].name, clip->rate(), rate);
+                continue;
+            }
+            clips[i] = clip;
+        } catch(const std::exception &e) {
+            syslog(LOG_WARNING, "sound <%s> not loaded <%s>", SOUNDS[i].name, e.what());
+        }
+    }
+
+    mixBuffer.resize(period * SoundSink::CHANNELS);
+    outBuffer.resize(period * SoundSink::CHANNELS);
+    mixerThread = clock->startThread([this]{mixerControl();});
+}
+
+SoundEngine::~SoundEngine() noexcept {
+    stopMixer();
+}
+
+void SoundEngine::stopMixer() {
+    running = false;
+    if(mixerThread.joinable()) {
+        mixerThread.join();
+    }
+}
+
+bool SoundEngine::parse(std::string_view name, Sound &sound) {
+    for(std::size_t i = 0; i < SOUND_COUNT; ++i) {
+        if(name == SOUNDS[i].name) {
+            sound = static_cast<Sound>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+void SoundEngine::start(Sound sound, Clock::TimePoint at) {
+    auto now = toNs(clock->now());
+    push(Command{Command::Type::START, sound, 0, 0, fadeFrames, std::max(toNs(at), now), now});
+}
+
+void SoundEngine::stop(Sound sound) {
+    auto now = toNs(clock->now());
+    push(Command{Command::Type::STOP, sound, 0, 0, fadeFrames, now, now});
+}
+
+void SoundEngine::crossfade(Sound from, Sound to) {
+    stop(from);
+    start(to);
+}
+
+void SoundEngine::setLoops(std::uint32_t on, std::uint32_t off) {
+    auto now = toNs(clock->now());
+    push(Command{
+        Command::Type::LOOPS, Sound::RAIN, static_cast<std::uint8_t>(on), static_cast<std::uint8_t>(off),
+        fadeFrames, now, now
+    });
+}
+
+void SoundEngine::stopAll() {
+    for(std::size_t i = 0; i < SOUND_COUNT; ++i) {
+        if(SOUNDS[i].loop) {
+            stop(static_cast<Sound>(i));
+        }
+    }
+}
+
+SoundEngine::Stats SoundEngine::getStats() const {
+    return Stats{
+        starts.load(),
+        std::chrono::nanoseconds{lastLatency.load()},
+        std::chrono::nanoseconds{maxLatency.load()},
+        dropped.load()
+    };
+}
+
+void SoundEngine::push(const Command &cmd) {
+    if(!commands.push(cmd)) {
+        ++dropped;
+    }
+}
+
+std::int64_t SoundEngine::toNs(Clock::TimePoint t) const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+void SoundEngine::mixerControl() {
+    const auto periodNs = static_cast<std::int64_t>(period) * 1000000000 / rate;
+
+    while(running) {
+        // when the first frame of this period becomes audible
+        auto periodStart = clock->now() + std::chrono::nanoseconds{
+            static_cast<std::int64_t>(sink->delay()) * 1000000000 / rate
+        };
+        auto periodEnd = toNs(periodStart) + periodNs;
+
+        Command cmd;
+        while(commands.pop(cmd)) {
+            if(pendingCount == MAX_PENDING) {
+                ++dropped;
+                continue;
+            }
+            pending[pendingCount++] = cmd;
+        }
+
+        // stable, so a stop and a start in the same period keep their order
+        std::size_t kept = 0;
+        for(std::size_t i = 0; i < pendingCount; ++i) {
+            if(pending[i].at < periodEnd) {
+                apply(pending[i], periodStart);
+            } else {
+                pending[kept++] = pending[i];
+            }
+        }
+        pendingCount = kept;
+
+        std::fill(mixBuffer.begin(), mixBuffer.end(), 0.0f);
+        for(auto &voice: voices) {
+            if(voice.clip) {
+                mix(mixBuffer.data(), voice);
+            }
+        }
+        for(std::size_t i = 0; i < mixBuffer.size(); ++i) {
+            outBuffer[i] = static_cast<std::int16_t>(std::clamp(mixBuffer[i] * volume, -32768.0f, 32767.0f));
+        }
+        sink->write(outBuffer.data(), period);
+    }
+}
+
+void SoundEngine::apply(const Command &cmd, Clock::TimePoint periodStart) {
+    if(cmd.type == Command::Type::LOOPS) {
+        // the stops first, so a voice is free for the starts
+        auto single = cmd;
+        for(auto type: {Command::Type::STOP, Command::Type::START}) {
+            auto mask = type == Command::Type::STOP ? cmd.off : cmd.on;
+            for(std::size_t i = 0; i < SOUND_COUNT; ++i) {
+                if(SOUNDS[i].loop && (mask & (1u << i))) {
+                    single.type = type;
+                    single.sound = static_cast<Sound>(i);
+                    apply(single, periodStart);
+                }
+            }
+        }
+        return;
+    }
+
+    auto idx = static_cast<std::size_t>(cmd.sound);
+    bool loop = SOUNDS[idx].loop;
+
+    if(cmd.type == Command::Type::STOP) {
+        for(auto &voice: voices) {
+            if(voice.clip && voice.loop && voice.sound == cmd.sound) {
+                if(voice.gain <= 0.0f) {
+                    voice.clip = nullptr;
+                    continue;
+                }
+                voice.target = 0.0f;
+                voice.step = cmd.fadeFrames ? -voice.gain / cmd.fadeFrames : -voice.gain;
+            }
+        }
+        return;
+    }
+
+    auto clip = clips[idx].get();
+    if(!clip || !clip->frames()) {
+        return;
+    }
+
+    auto startNs = std::max(cmd.at, toNs(periodStart));
+    auto offset = static_cast<std::size_t>((startNs - toNs(periodStart)) * rate / 1000000000);
+
+    Voice *voice = nullptr;
+    if(loop) {
+        // a loop (still) playing is faded back in instead of starting twice
+        for(auto &v: voices) {
+            if(v.clip && v.sound == cmd.sound) {
+                voice = &v;
+                break;
+            }
+        }
+        if(voice) {
+            voice->target = 1.0f;
+            voice->step = cmd.fadeFrames ? (1.0f - voice->gain) / cmd.fadeFrames : 1.0f;
+            return;
+        }
+    }
+    for(auto &v: voices) {
+        if(!v.clip) {
+            voice = &v;
+            break;
+        }
+    }
+    if(!voice) {
+        ++dropped;
+        syslog(LOG_WARNING, "sound <%s> dropped, all voices in use", SOUNDS[idx].name);
+        return;
+    }
+
+    *voice = Voice{};
+    voice->clip = clip;
+    voice->sound = cmd.sound;
+    voice->loop = loop;
+    voice->offset = std::min(offset, period - 1);
+    voice->target = 1.0f;
+    if(loop && cmd.fadeFrames) {
+        voice->gain = 0.0f;
+        voice->step = 1.0f / cmd.fadeFrames;
+    } else {
+        voice->gain = 1.0f;
+    }
+
+    auto audible = toNs(periodStart) + static_cast<std::int64_t>(voice->offset) * 1000000000 / rate;
+    auto latency = audible - cmd.issuedAt;
+    lastLatency = latency;
+    if(latency > maxLatency) {
+        maxLatency = latency;
+    }
+    ++starts;
+}
+
+void SoundEngine::mix(float *buf, Voice &voice) {
+    auto clip = voice.clip;
+    auto data = clip->data();
+    auto channels = clip->channels();
+
+    for(std::size_t i = std::exchange(voice.offset, 0); i < period; ++i) {
+        if(voice.pos == clip->frames()) {
+            if(!voice.loop) {
+                voice.clip = nullptr;
+                return;
+            }
+            voice.pos = 0;
+        }
+        if(voice.step != 0.0f) {
+            voice.gain += voice.step;
+            if((voice.step > 0.0f && voice.gain >= voice.target) || (voice.step < 0.0f && voice.gain <= voice.target)) {
+                voice.gain = voice.target;
+                voice.step = 0.0f;
+                if(voice.gain == 0.0f) {
+                    voice.clip = nullptr;
+                    return;
+                }
+            }
+        }
+        auto frame = data + voice.pos * channels;
+        buf[2 * i] += frame[0] * voice.gain;
+        buf[2 * i + 1] += frame[channels - 1] * voice.gain;
+        ++voice.pos;
+    }
+}
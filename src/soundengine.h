@@ -0,0 +1,179 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <moba-common/ini.h>
+
+#include "clock.h"
+#include "mpscring.h"
+#include "soundclip.h"
+#include "soundsink.h"
+
+/**
+ * Ambient sound: loops (rain, birds, wind) fade in and out, one shots
+ * (thunder) may overlap. The clips are 16 bit PCM wave files, configured in
+ * section [sound] by their name, e.g. rain=/usr/share/moba-environment/rain.wav;
+ * a clip needs the rate of the sink.
+ *
+ * Callers only push a command into a lock free ring. The mixer thread mixes
+ * one period at a time into preallocated buffers and writes it to the sink;
+ * a start is placed on the exact frame of its start time, so e.g. thunder can
+ * be scheduled right after its flash.
+ */
+class SoundEngine final {
+public:
+    enum class Sound: std::uint8_t {
+        RAIN    = 0,
+        BIRDS   = 1,
+        WIND    = 2,
+        THUNDER = 3,
+    };
+
+    static constexpr std::size_t SOUND_COUNT = 4;
+
+    struct Stats {
+        std::uint64_t starts;
+        // from the call of start() until the first frame of the sound is audible
+        Clock::Duration lastLatency;
+        Clock::Duration maxLatency;
+        // commands dropped because the ring or all voices were in use
+        std::uint64_t dropped;
+    };
+
+    SoundEngine(SoundSinkPtr sink, moba::IniPtr ini, ClockPtr clock);
+    ~SoundEngine() noexcept;
+
+    SoundEngine(const SoundEngine&) = delete;
+    SoundEngine& operator=(const SoundEngine&) = delete;
+
+    /**
+     * @return false if name is not a sound
+     */
+    static bool parse(std::string_view name, Sound &sound);
+
+    /**
+     * Fades in a loop or plays a one shot, not before at. Lock free, like all
+     * commands; fades take [sound] fade ms.
+     */
+    void start(Sound sound, Clock::TimePoint at = Clock::TimePoint{});
+
+    /**
+     * Fades out a loop, a one shot plays to its end anyway.
+     */
+    void stop(Sound sound);
+
+    void crossfade(Sound from, Sound to);
+
+    /**
+     * Fades the loops in on (bit per Sound) in and those in off out, all
+     * starting on the same frame. One shots are ignored.
+     */
+    void setLoops(std::uint32_t on, std::uint32_t off);
+
+    void stopAll();
+
+    Stats getStats() const;
+
+    /**
+     * Stops and joins the mixer, the sink is not written afterwards.
+     */
+    void stopMixer();
+
+private:
+    static constexpr std::size_t MAX_VOICES = 8;
+    static constexpr std::size_t MAX_PENDING = 32;
+
+    struct Command {
+        enum class Type: std::uint8_t {
+            START,
+            STOP,
+            LOOPS,
+        };
+
+        Type type;
+        Sound sound;
+        // LOOPS only, bit per Sound
+        std::uint8_t on;
+        std::uint8_t off;
+        std::uint32_t fadeFrames;
+        // ns since clock epoch
+        std::int64_t at;
+        std::int64_t issuedAt;
+    };
+
+    struct Voice {
+        const SoundClip *clip{nullptr};
+        Sound sound;
+        std::size_t pos{0};
+        bool loop{false};
+        float gain{0.0f};
+        float target{0.0f};
+        float step{0.0f};
+        // frames of silence before the clip starts, within the current period
+        std::size_t offset{0};
+    };
+
+    void mixerControl();
+    void apply(const Command &cmd, Clock::TimePoint periodStart);
+    void mix(float *buf, Voice &voice);
+    void push(const Command &cmd);
+
+    std::int64_t toNs(Clock::TimePoint t) const;
+
+    SoundSinkPtr sink;
+    ClockPtr clock;
+
+    std::size_t period;
+    unsigned int rate;
+    float volume;
+    std::uint32_t fadeFrames;
+
+    std::array<SoundClipPtr, SOUND_COUNT> clips;
+
+    MpscRing<Command, 64> commands;
+
+    // mixer thread only
+    std::array<Command, MAX_PENDING> pending;
+    std::size_t pendingCount{0};
+    std::array<Voice, MAX_VOICES> voices;
+    std::vector<float> mixBuffer;
+    std::vector<std::int16_t> outBuffer;
+
+    std::atomic<std::uint64_t> starts{0};
+    std::atomic<std::int64_t> lastLatency{0};
+    std::atomic<std::int64_t> maxLatency{0};
+    std::atomic<std::uint64_t> dropped{0};
+
+    std::atomic<bool> running{true};
+    std::thread mixerThread;
+};
+
+using SoundEnginePtr = std::shared_ptr<SoundEngine>;
@@ -0,0 +1,119 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "soundsink.h"
+#include "alsasink.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <syslog.h>
+
+NullSink::NullSink(unsigned int rate, ClockPtr clock): sampleRate{rate}, clock{clock} {
+}
+
+void NullSink::write(const std::int16_t*, std::size_t count) {
+    auto now = clock->now();
+    if(!started || deadline < now) {
+        // underrun, the stream restarts now
+        deadline = now;
+        started = true;
+    }
+    auto start = deadline;
+    deadline += std::chrono::nanoseconds{static_cast<std::int64_t>(count) * 1000000000 / sampleRate};
+    if(start > now) {
+        clock->sleepFor(start - now);
+    }
+}
+
+std::size_t NullSink::delay() {
+    auto now = clock->now();
+    if(!started || deadline <= now) {
+        return 0;
+    }
+    return static_cast<std::size_t>(std::chrono::nanoseconds{deadline - now}.count() * sampleRate / 1000000000);
+}
+
+FileSink::FileSink(const std::string &path, unsigned int rate, ClockPtr clock):
+NullSink{rate, clock}, out{path, std::ios::binary | std::ios::trunc} {
+    if(!out) {
+        throw std::runtime_error{"unable to open <" + path + ">"};
+    }
+    writeHeader();
+}
+
+FileSink::~FileSink() noexcept {
+    out.seekp(0);
+    writeHeader();
+}
+
+void FileSink::write(const std::int16_t *frames, std::size_t count) {
+    auto size = count * CHANNELS * sizeof(std::int16_t);
+    out.write(reinterpret_cast<const char*>(frames), size);
+    dataSize += size;
+    NullSink::write(frames, count);
+}
+
+void FileSink::writeHeader() {
+    auto le32 = [this](std::uint32_t v) {
+        char b[] = {char(v), char(v >> 8), char(v >> 16), char(v >> 24)};
+        out.write(b, 4);
+    };
+    auto le16 = [this](std::uint16_t v) {
+        char b[] = {char(v), char(v >> 8)};
+        out.write(b, 2);
+    };
+    out.write("RIFF", 4);
+    le32(36 + dataSize);
+    out.write("WAVEfmt ", 8);
+    le32(16);
+    le16(1);
+    le16(CHANNELS);
+    le32(sampleRate);
+    le32(sampleRate * CHANNELS * 2);
+    le16(CHANNELS * 2);
+    le16(16);
+    out.write("data", 4);
+    le32(dataSize);
+}
+
+SoundSinkPtr createSoundSink(const moba::IniPtr &ini, ClockPtr clock) {
+    auto sink = ini->getString("sound", "sink", "alsa");
+    auto rate = static_cast<unsigned int>(std::clamp(ini->getInt("sound", "rate", 44100), 8000, 192000));
+
+    try {
+        if(sink == "alsa") {
+            auto device = ini->getString("sound", "device", "default");
+            auto period = static_cast<std::size_t>(std::clamp(ini->getInt("sound", "period", 256), 32, 8192));
+            syslog(LOG_INFO, "sound sink <alsa> on <%s>", device.c_str());
+            return std::make_shared<AlsaSink>(device, rate, period, clock);
+        }
+        if(sink == "file") {
+            auto file = ini->getString("sound", "file", "/tmp/moba-environment.wav");
+            syslog(LOG_INFO, "sound sink <file> to <%s>", file.c_str());
+            return std::make_shared<FileSink>(file, rate, clock);
+        }
+        if(sink != "null") {
+            syslog(LOG_WARNING, "unknown sound sink <%s>", sink.c_str());
+        }
+    } catch(const std::exception &e) {
+        syslog(LOG_ERR, "sound sink <%s> failed <%s>, sound is muted", sink.c_str(), e.what());
+    }
+    return std::make_shared<NullSink>(rate, clock);
+}
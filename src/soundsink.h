@@ -0,0 +1,100 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include <moba-common/ini.h>
+
+#include "clock.h"
+
+/**
+ * Output of the sound engine: interleaved 16 bit stereo at a fixed rate.
+ * write() blocks until the device takes the frames and so paces the mixer.
+ */
+class SoundSink {
+public:
+    static constexpr unsigned int CHANNELS = 2;
+
+    virtual ~SoundSink() noexcept = default;
+
+    virtual void write(const std::int16_t *frames, std::size_t count) = 0;
+
+    /**
+     * Frames written but not yet audible.
+     */
+    virtual std::size_t delay() = 0;
+
+    virtual unsigned int rate() const = 0;
+};
+
+using SoundSinkPtr = std::shared_ptr<SoundSink>;
+
+/**
+ * Drops the frames, but paces like a device buffering one write: write()
+ * returns when the frames written start playing.
+ */
+class NullSink : public SoundSink {
+public:
+    NullSink(unsigned int rate, ClockPtr clock);
+
+    void write(const std::int16_t *frames, std::size_t count) override;
+    std::size_t delay() override;
+
+    unsigned int rate() const override {
+        return sampleRate;
+    }
+
+protected:
+    unsigned int sampleRate;
+    ClockPtr clock;
+
+    // when the frames written so far have been played
+    Clock::TimePoint deadline;
+    bool started{false};
+};
+
+/**
+ * Like NullSink, but writes everything to a wave file (e.g. to check a mix).
+ */
+class FileSink final : public NullSink {
+public:
+    FileSink(const std::string &path, unsigned int rate, ClockPtr clock);
+    ~FileSink() noexcept override;
+
+    void write(const std::int16_t *frames, std::size_t count) override;
+
+private:
+    void writeHeader();
+
+    std::ofstream out;
+    std::uint32_t dataSize{0};
+};
+
+/**
+ * [sound] sink=alsa|null|file, device=<alsa pcm>, file=<wave file>, rate=<Hz>,
+ * period=<frames>. Falls back to null if the alsa device can't be opened.
+ */
+SoundSinkPtr createSoundSink(const moba::IniPtr &ini, ClockPtr clock);
@@ -0,0 +1,115 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+
+template<typename State, typename Event>
+struct Transition {
+    State from;
+    Event event;
+    State to;
+};
+
+/**
+ * Transition table, checked while compiling: a (state, event) pair must not
+ * be listed twice. Every pair missing from the table is an illegal
+ * transition; the ones the code fires itself can be checked with
+ * static_assert(table.accepts(...)).
+ */
+template<typename State, typename Event, std::size_t N>
+class TransitionTable final {
+public:
+    consteval TransitionTable(const Transition<State, Event> (&entries)[N]) {
+        for(std::size_t i = 0; i < N; ++i) {
+            for(std::size_t j = 0; j < i; ++j) {
+                if(entries[i].from == entries[j].from && entries[i].event == entries[j].event) {
+                    // not a constant expression, so a duplicate fails to compile
+                    throw std::logic_error{"duplicate transition"};
+                }
+            }
+            table[i] = entries[i];
+        }
+    }
+
+    constexpr bool accepts(State from, Event event) const {
+        return find(from, event) != nullptr;
+    }
+
+    /**
+     * @return false if the transition is illegal, to is left untouched then
+     */
+    constexpr bool next(State from, Event event, State &to) const {
+        auto t = find(from, event);
+        if(!t) {
+            return false;
+        }
+        to = t->to;
+        return true;
+    }
+
+private:
+    constexpr const Transition<State, Event> *find(State from, Event event) const {
+        for(const auto &t: table) {
+            if(t.from == from && t.event == event) {
+                return &t;
+            }
+        }
+        return nullptr;
+    }
+
+    std::array<Transition<State, Event>, N> table{};
+};
+
+/**
+ * Current state of one machine. Only the owning thread fires events, any
+ * thread may read the state.
+ */
+template<typename State, typename Event, std::size_t N>
+class StateMachine final {
+public:
+    constexpr StateMachine(const TransitionTable<State, Event, N> &table, State initial):
+    table{table}, current{initial} {
+    }
+
+    /**
+     * @return false if the event is illegal in the current state, nothing changes then
+     */
+    bool fire(Event event, State &from, State &to) {
+        from = current.load(std::memory_order_relaxed);
+        if(!table.next(from, event, to)) {
+            return false;
+        }
+        current.store(to, std::memory_order_release);
+        return true;
+    }
+
+    State state() const {
+        return current.load(std::memory_order_acquire);
+    }
+
+private:
+    const TransitionTable<State, Event, N> &table;
+    std::atomic<State> current;
+};
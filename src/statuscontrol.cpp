@@ -20,23 +20,63 @@
 
 #include "statuscontrol.h"
 
+#include <algorithm>
 #include <thread>
 #include <syslog.h>
 #include "moba/systemmessages.h"
 
-StatusControl::StatusControl(BridgePtr bridge, EndpointPtr endpoint): bridge{bridge}, endpoint{endpoint} {
-    switchStateThread  = std::thread{&StatusControl::switchStateControl, this};
-    statusBarThread = std::thread{&StatusControl::statusBarControl, this};
+StatusControl::StatusControl(
+    BridgePtr bridge, moba::IniPtr ini, EndpointPtr endpoint, ClockPtr clock, WatchdogPtr watchdog,
+    ShutdownControlPtr shutdown
+): bridge{bridge}, endpoint{endpoint}, clock{clock}, shutdown{shutdown} {
+    if(ini->getInt("status", "pwm", 0)) {
+        pwm =
+            bridge->setupPwm(Bridge::STATUS_RED) != GpioBackend::Pwm::NONE &&
+            bridge->setupPwm(Bridge::STATUS_GREEN) != GpioBackend::Pwm::NONE;
+        if(!pwm) {
+            syslog(LOG_WARNING, "status bar: no PWM on the status leds, switched by the status bar thread");
+        }
+        brightness = std::clamp<int>(ini->getInt("status", "brightness", PwmPattern::FULL), 0, PwmPattern::FULL);
+    }
+
+    switchStateHeartbeat = watchdog->registerLoop("switch_state", std::chrono::milliseconds{1000});
+    switchStateThread  = clock->startThread([this]{switchStateControl();});
+    if(pwm) {
+        playStatusBar(statusBarState);
+        return;
+    }
+    statusBarHeartbeat = watchdog->registerLoop("status_bar", std::chrono::milliseconds{1000});
+    statusBarThread = clock->startThread([this]{statusBarControl();});
 }
 
 StatusControl::~StatusControl() {
+    stop();
+}
+
+void StatusControl::stop() {
     running = false;
-    switchStateThread.join();
-    statusBarThread.join();
+    if(switchStateThread.joinable()) {
+        switchStateThread.join();
+    }
+    if(statusBarThread.joinable()) {
+        statusBarThread.join();
+    }
+    if(pwm) {
+        bridge->playPwm(Bridge::STATUS_RED, PwmPattern::level(0));
+        bridge->playPwm(Bridge::STATUS_GREEN, PwmPattern::level(0));
+    }
 }
 
 void StatusControl::setStatusBar(StatusBarState sbstate) {
-    statusBarState = sbstate;
+    if(pwm) {
+        // in order, setStatusBar() is called from more than one thread
+        std::lock_guard<std::mutex> l{statusBarMutex};
+        if(statusBarState.exchange(sbstate) != sbstate) {
+            playStatusBar(sbstate);
+        }
+    } else {
+        statusBarState = sbstate;
+    }
     switch(statusBarState) {
         case StatusBarState::ERROR:
             syslog(LOG_INFO, "set statusbar to <ERROR>");
@@ -70,48 +110,60 @@ void StatusControl::switchStateControl() {
 
     while(running) {
 
-        while(bridge->getDebounced(Bridge::PUSH_BUTTON_STATE)) {
-            std::this_thread::sleep_for(std::chrono::milliseconds{50});
+        while(running && bridge->getDebounced(Bridge::PUSH_BUTTON_STATE)) {
+            switchStateHeartbeat->beat();
+            clock->sleepFor(std::chrono::milliseconds{50});
         }
 
         int cntOn = 0;
 
-        while(!bridge->getDebounced(Bridge::PUSH_BUTTON_STATE)) {
+        while(running && !bridge->getDebounced(Bridge::PUSH_BUTTON_STATE)) {
+            switchStateHeartbeat->beat();
             cntOn++;
-            std::this_thread::sleep_for(std::chrono::milliseconds{5});
+            clock->sleepFor(std::chrono::milliseconds{5});
+        }
+
+        if(!running) {
+            break;
         }
 
         if(cntOn < 300) { // 300 * 5ms -> 1.5 seconds
             syslog(LOG_INFO, "SHORT_ONCE (< 1.5s pressed) [standby]");
-            endpoint->sendMsg(SystemToggleStandbyMode{});
+            sendMsg(SystemToggleStandbyMode{});
             continue;
         }
 
         syslog(LOG_INFO, "LONG_ONCE (> 1.5s pressed) [shutdown]");
-        endpoint->sendMsg(SystemHardwareShutdown{});
+        if(shutdown) {
+            // the server might be unreachable, so do not rely on its ClientShutdown
+            shutdown->request(ShutdownControl::Action::HALT, "push button");
+        }
+        sendMsg(SystemHardwareShutdown{});
     }
+    switchStateHeartbeat->pause();
 }
 
 void StatusControl::statusBarControl() {
     while(running) {
+        statusBarHeartbeat->beat();
         StatusBarState sbs = statusBarState;
 
         switch(sbs) {
             case StatusBarState::ERROR:
             case StatusBarState::INIT:
             case StatusBarState::EMERGENCY_STOP:
-                bridge->setHigh(Bridge::STATUS_RED);
-                bridge->setLow(Bridge::STATUS_GREEN);
+                bridge->setMask(Bridge::mask(Bridge::STATUS_RED), Bridge::mask(Bridge::STATUS_GREEN));
                 break;
 
             case StatusBarState::STANDBY:
             case StatusBarState::MANUEL:
             case StatusBarState::AUTOMATIC:
-                bridge->setLow(Bridge::STATUS_RED);
-                bridge->setHigh(Bridge::STATUS_GREEN);
+                bridge->setMask(Bridge::mask(Bridge::STATUS_GREEN), Bridge::mask(Bridge::STATUS_RED));
                 break;
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(25));
+        if(!hold(FLASH, sbs)) {
+            continue;
+        }
         switch(sbs) {
             case StatusBarState::EMERGENCY_STOP:
                 bridge->setLow(Bridge::STATUS_RED);
@@ -124,7 +176,9 @@ void StatusControl::statusBarControl() {
             default:
                 break;
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(700));
+        if(!hold(BLINK_ON - FLASH, sbs)) {
+            continue;
+        }
         switch(sbs) {
             case StatusBarState::INIT:
                 bridge->setLow(Bridge::STATUS_RED);
@@ -137,8 +191,65 @@ void StatusControl::statusBarControl() {
             default:
                 break;
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(750));
+        hold(BLINK_OFF, sbs);
+    }
+    statusBarHeartbeat->pause();
+    bridge->setMask(0, Bridge::mask(Bridge::STATUS_RED) | Bridge::mask(Bridge::STATUS_GREEN));
+}
+
+void StatusControl::playStatusBar(StatusBarState sbstate) {
+    PwmPattern pattern;
+    bool red = false;
+
+    switch(sbstate) {
+        case StatusBarState::INIT:
+            red = true;
+            pattern = PwmPattern::blink(BLINK_ON, BLINK_OFF, brightness);
+            break;
+
+        case StatusBarState::ERROR:
+            red = true;
+            pattern = PwmPattern::level(brightness);
+            break;
+
+        case StatusBarState::EMERGENCY_STOP:
+            red = true;
+            pattern = PwmPattern::blink(FLASH, BLINK_ON + BLINK_OFF - FLASH, brightness);
+            break;
+
+        case StatusBarState::STANDBY:
+            pattern = PwmPattern::breathe(BREATHE, 0, brightness);
+            break;
+
+        case StatusBarState::MANUEL:
+            pattern = PwmPattern::blink(BLINK_ON, BLINK_OFF, brightness);
+            break;
+
+        case StatusBarState::AUTOMATIC:
+            pattern = PwmPattern::level(brightness);
+            break;
+    }
+    // the one going dark first, so both are never lit at once
+    bridge->playPwm(red ? Bridge::STATUS_GREEN : Bridge::STATUS_RED, PwmPattern::level(0));
+    bridge->playPwm(red ? Bridge::STATUS_RED : Bridge::STATUS_GREEN, pattern);
+}
+
+bool StatusControl::hold(std::chrono::milliseconds duration, StatusBarState sbs) {
+    // sliced, so a new state (e.g. emergency stop) shows up within one slice instead of one pattern cycle
+    constexpr std::chrono::milliseconds slice{25};
+
+    // against a deadline, otherwise the oversleep of every slice adds up
+    auto deadline = clock->now() + duration;
+
+    while(true) {
+        statusBarHeartbeat->beat();
+        if(!running || statusBarState != sbs) {
+            return false;
+        }
+        auto left = deadline - clock->now();
+        if(left <= Clock::Duration::zero()) {
+            return true;
+        }
+        clock->sleepFor(std::min<Clock::Duration>(left, slice));
     }
-    bridge->setLow(Bridge::STATUS_RED);
-    bridge->setLow(Bridge::STATUS_GREEN);
 }
@@ -21,13 +21,30 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <exception>
 #include <thread>
 #include <memory>
+#include <mutex>
+#include <syslog.h>
+
+#include <moba-common/ini.h>
 
 #include "moba/endpoint.h"
 
 #include "bridge.h"
+#include "clock.h"
+#include "shutdowncontrol.h"
+#include "watchdog.h"
 
+/**
+ * Status bar (two leds) and push button. With [status] pwm=1 and a backend
+ * that can drive both leds with PWM, the patterns are handed to the backend
+ * once per state change instead of being switched by the status bar thread;
+ * STANDBY then breathes instead of flashing. Section [status]:
+ *   pwm=0|1
+ *   brightness=<permille>   pwm only
+ */
 class StatusControl {
 public:
    enum class StatusBarState {
@@ -40,7 +57,14 @@ public:
         AUTOMATIC      = 5    // gruen
     };
 
-    StatusControl(BridgePtr bridge, EndpointPtr endpoint);
+    /**
+     * endpoint may be null (simulation), outgoing messages are dropped then;
+     * shutdown may be null, a long button press only sends the message then
+     */
+    StatusControl(
+        BridgePtr bridge, moba::IniPtr ini, EndpointPtr endpoint, ClockPtr clock, WatchdogPtr watchdog,
+        ShutdownControlPtr shutdown
+    );
     virtual ~StatusControl();
 
     StatusControl(const StatusControl&) = delete;
@@ -48,18 +72,63 @@ public:
 
     void setStatusBar(StatusBarState sbstate);
 
+    /**
+     * Stops and joins both threads, the status leds are switched off.
+     */
+    void stop();
+
 private:
+    // the status bar pattern: on for 25ms, then as below, on for 700ms, then off for 750ms
+    static constexpr std::chrono::milliseconds FLASH{25};
+    static constexpr std::chrono::milliseconds BLINK_ON{725};
+    static constexpr std::chrono::milliseconds BLINK_OFF{750};
+    static constexpr std::chrono::milliseconds BREATHE{3000};
+
     void switchStateControl();
     void statusBarControl();
 
+    /**
+     * Hands the pattern of sbstate to the backend.
+     */
+    void playStatusBar(StatusBarState sbstate);
+
+    /**
+     * Keeps the current pattern step for duration.
+     * @return false if the state changed meanwhile
+     */
+    bool hold(std::chrono::milliseconds duration, StatusBarState sbs);
+
+    template<typename T>
+    void sendMsg(const T &msg) {
+        if(!endpoint) {
+            syslog(LOG_WARNING, "no endpoint, message <%u/%u> dropped", T::GROUP_ID, T::MESSAGE_ID);
+            return;
+        }
+        try {
+            endpoint->sendMsg(msg);
+        } catch(const std::exception &e) {
+            // server down or not connected yet
+            syslog(LOG_WARNING, "message <%u/%u> not sent <%s>", T::GROUP_ID, T::MESSAGE_ID, e.what());
+        }
+    }
+
     BridgePtr bridge;
     EndpointPtr endpoint;
+    ClockPtr clock;
+    ShutdownControlPtr shutdown;
+
+    Watchdog::HeartbeatPtr switchStateHeartbeat;
+    Watchdog::HeartbeatPtr statusBarHeartbeat;
 
     std::thread statusBarThread;
     std::thread switchStateThread;
 
     std::atomic<bool> running{true};
     std::atomic<StatusBarState> statusBarState{StatusBarState::INIT};
+
+    bool pwm{false};
+    std::uint16_t brightness{PwmPattern::FULL};
+    std::mutex statusBarMutex;
 };
 
 using StatusControlPtr = std::shared_ptr<StatusControl>;
@@ -0,0 +1,125 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "moba/environmentmessages.h"
+
+/*
+ * Clock synchronisation between environment nodes. Not part of lib-msghandling
+ * (yet), the server only has to pass them on to every environment client.
+ * Times are ns of the sender's monotonic clock, or of the reference node's
+ * where noted.
+ */
+
+struct EnvClockPing: public EnvironmentMessage {
+    static constexpr std::uint32_t MESSAGE_ID = 17;
+
+    EnvClockPing(std::uint8_t node, std::uint32_t seq, std::int64_t sent): node{node}, seq{seq}, sent{sent} {
+    }
+
+    explicit EnvClockPing(const nlohmann::json &d) {
+        node = d["node"].get<int>();
+        seq = d["seq"].get<std::uint32_t>();
+        sent = d["sent"].get<std::int64_t>();
+    }
+
+    nlohmann::json getJsonDocument() const {
+        nlohmann::json d;
+        d["node"] = static_cast<int>(node);
+        d["seq"] = seq;
+        d["sent"] = sent;
+        return d;
+    }
+
+    std::uint8_t node;
+    std::uint32_t seq;
+    std::int64_t sent;
+};
+
+/**
+ * Answer of the reference node, node is the one that pinged.
+ */
+struct EnvClockPong: public EnvironmentMessage {
+    static constexpr std::uint32_t MESSAGE_ID = 18;
+
+    EnvClockPong(std::uint8_t node, std::uint32_t seq, std::int64_t sent, std::int64_t received, std::int64_t replied):
+    node{node}, seq{seq}, sent{sent}, received{received}, replied{replied} {
+    }
+
+    explicit EnvClockPong(const nlohmann::json &d) {
+        node = d["node"].get<int>();
+        seq = d["seq"].get<std::uint32_t>();
+        sent = d["sent"].get<std::int64_t>();
+        received = d["received"].get<std::int64_t>();
+        replied = d["replied"].get<std::int64_t>();
+    }
+
+    nlohmann::json getJsonDocument() const {
+        nlohmann::json d;
+        d["node"] = static_cast<int>(node);
+        d["seq"] = seq;
+        d["sent"] = sent;
+        d["received"] = received;
+        d["replied"] = replied;
+        return d;
+    }
+
+    std::uint8_t node;
+    std::uint32_t seq;
+    // ping's sent, echoed
+    std::int64_t sent;
+    // reference clock
+    std::int64_t received;
+    std::int64_t replied;
+};
+
+/**
+ * An effect every node starts at the same moment, at is reference clock.
+ */
+struct EnvSyncedEffect: public EnvironmentMessage {
+    static constexpr std::uint32_t MESSAGE_ID = 19;
+
+    EnvSyncedEffect(std::uint8_t node, std::string effect, std::int64_t at): node{node}, effect{std::move(effect)}, at{at} {
+    }
+
+    explicit EnvSyncedEffect(const nlohmann::json &d) {
+        node = d["node"].get<int>();
+        effect = d["effect"].get<std::string>();
+        at = d["at"].get<std::int64_t>();
+    }
+
+    nlohmann::json getJsonDocument() const {
+        nlohmann::json d;
+        d["node"] = static_cast<int>(node);
+        d["effect"] = effect;
+        d["at"] = at;
+        return d;
+    }
+
+    // the sender, which already scheduled it
+    std::uint8_t node;
+    std::string effect;
+    std::int64_t at;
+};
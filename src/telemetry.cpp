@@ -0,0 +1,267 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "telemetry.h"
+
+#include <algorithm>
+#include <exception>
+#include <limits>
+#include <string>
+#include <syslog.h>
+#include <utility>
+#include <zlib.h>
+
+#include "moba/environmentmessages.h"
+
+namespace {
+    // version, count and base time
+    constexpr std::size_t MAX_HEADER = 1 + 5 + 10;
+    // time, kind, id, value
+    constexpr std::size_t MAX_SAMPLE = 10 + 1 + 1 + 5;
+
+    /**
+     * Not part of lib-msghandling (yet), the server has to know the id.
+     */
+    struct EnvTelemetryBatch: public EnvironmentMessage {
+        static constexpr std::uint32_t MESSAGE_ID = Telemetry::BATCH_MESSAGE_ID;
+
+        EnvTelemetryBatch(std::size_t samples, std::size_t rawSize, std::string data):
+        samples{samples}, rawSize{rawSize}, data{std::move(data)} {
+        }
+
+        nlohmann::json getJsonDocument() const {
+            nlohmann::json d;
+            d["encoding"] = std::string{"zlib"};
+            d["samples"] = samples;
+            d["rawSize"] = rawSize;
+            d["data"] = data;
+            return d;
+        }
+
+        std::size_t samples;
+        std::size_t rawSize;
+        // base64
+        std::string data;
+    };
+
+    void putVarint(std::vector<std::uint8_t> &out, std::uint64_t v) {
+        while(v >= 0x80) {
+            out.push_back(static_cast<std::uint8_t>(v) | 0x80);
+            v >>= 7;
+        }
+        out.push_back(static_cast<std::uint8_t>(v));
+    }
+
+    std::uint32_t zigzag(std::int32_t v) {
+        return (static_cast<std::uint32_t>(v) << 1) ^ static_cast<std::uint32_t>(v >> 31);
+    }
+
+    std::string toBase64(const std::uint8_t *data, std::size_t size) {
+        static constexpr char chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+        std::string out;
+        out.reserve((size + 2) / 3 * 4);
+        for(std::size_t i = 0; i < size; i += 3) {
+            std::uint32_t n = data[i] << 16;
+            if(i + 1 < size) {
+                n |= data[i + 1] << 8;
+            }
+            if(i + 2 < size) {
+                n |= data[i + 2];
+            }
+            out += chars[(n >> 18) & 63];
+            out += chars[(n >> 12) & 63];
+            out += i + 1 < size ? chars[(n >> 6) & 63] : '=';
+            out += i + 2 < size ? chars[n & 63] : '=';
+        }
+        return out;
+    }
+}
+
+Telemetry::Telemetry(EndpointPtr endpoint, moba::IniPtr ini, ClockPtr clock): endpoint{endpoint}, clock{clock} {
+    interval = std::chrono::milliseconds{std::max(ini->getInt("telemetry", "interval", 5000), 100)};
+    batchSize = std::max(ini->getInt("telemetry", "batch", 512), 1);
+    level = std::clamp(ini->getInt("telemetry", "level", 6), 1, 9);
+
+    times.reserve(batchSize);
+    kinds.reserve(batchSize);
+    ids.reserve(batchSize);
+    values.reserve(batchSize);
+    raw.reserve(MAX_HEADER + batchSize * MAX_SAMPLE);
+    compressed.resize(compressBound(raw.capacity()));
+
+    counters.push_back({Counter::TELEMETRY_DROPPED, [this]{return dropped.load();}, 0});
+}
+
+void Telemetry::start() {
+    collectThread = clock->startThread([this]{collect();});
+}
+
+Telemetry::~Telemetry() noexcept {
+    stop();
+}
+
+void Telemetry::stop() {
+    running = false;
+    if(collectThread.joinable()) {
+        collectThread.join();
+    }
+}
+
+void Telemetry::record(Kind kind, std::uint8_t id, std::int32_t value) {
+    auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(clock->now().time_since_epoch()).count();
+    if(!ring.push(Sample{time, kind, id, value})) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Telemetry::addCounter(Counter id, std::function<std::uint64_t()> read) {
+    std::lock_guard<std::mutex> l{m};
+    counters.push_back({id, std::move(read), 0});
+}
+
+Telemetry::Stats Telemetry::getStats() {
+    std::lock_guard<std::mutex> l{m};
+    auto s = stats;
+    s.dropped = dropped;
+    return s;
+}
+
+void Telemetry::collect() {
+    auto nextFlush = clock->now() + interval;
+    while(running) {
+        clock->sleepFor(COLLECT_INTERVAL);
+        drain();
+        if(clock->now() >= nextFlush) {
+            sampleCounters();
+            flush();
+            nextFlush = clock->now() + interval;
+        }
+    }
+    drain();
+    sampleCounters();
+    flush();
+}
+
+void Telemetry::drain() {
+    Sample sample;
+    while(ring.pop(sample)) {
+        append(sample);
+    }
+}
+
+void Telemetry::append(const Sample &sample) {
+    times.push_back(sample.time);
+    kinds.push_back(sample.kind);
+    ids.push_back(sample.id);
+    values.push_back(sample.value);
+    if(times.size() >= batchSize) {
+        flush();
+    }
+}
+
+void Telemetry::sampleCounters() {
+    std::lock_guard<std::mutex> l{m};
+    auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(clock->now().time_since_epoch()).count();
+    for(auto &counter: counters) {
+        auto value = counter.read();
+        if(value == counter.last) {
+            continue;
+        }
+        counter.last = value;
+        auto clamped = static_cast<std::int32_t>(std::min<std::uint64_t>(value, std::numeric_limits<std::int32_t>::max()));
+        // straight into the batch, a full ring would lose them
+        times.push_back(time);
+        kinds.push_back(Kind::COUNTER);
+        ids.push_back(static_cast<std::uint8_t>(counter.id));
+        values.push_back(clamped);
+    }
+}
+
+void Telemetry::flush() {
+    if(times.empty()) {
+        return;
+    }
+    encode();
+
+    // the counters may have pushed the batch past batchSize
+    if(compressed.size() < compressBound(raw.size())) {
+        compressed.resize(compressBound(raw.size()));
+    }
+    uLongf size = compressed.size();
+    auto rc = compress2(compressed.data(), &size, raw.data(), raw.size(), level);
+
+    std::size_t samples = times.size();
+    times.clear();
+    kinds.clear();
+    ids.clear();
+    values.clear();
+
+    if(rc != Z_OK) {
+        syslog(LOG_ERR, "telemetry: compress failed <%d>, batch of <%zu> samples dropped", rc, samples);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> l{m};
+        ++stats.batches;
+        stats.samples += samples;
+        stats.rawBytes += raw.size();
+        stats.compressedBytes += size;
+    }
+    if(!endpoint) {
+        return;
+    }
+    try {
+        endpoint->sendMsg(EnvTelemetryBatch{samples, raw.size(), toBase64(compressed.data(), size)});
+    } catch(const std::exception &e) {
+        // not connected (yet), the batch is lost
+        syslog(LOG_WARNING, "telemetry: send failed <%s>, batch of <%zu> samples dropped", e.what(), samples);
+        dropped.fetch_add(samples, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> l{m};
+        ++stats.unsent;
+    }
+}
+
+void Telemetry::encode() {
+    raw.clear();
+    raw.push_back(FORMAT_VERSION);
+    putVarint(raw, times.size());
+
+    // steady clock of sample 0 to wall clock
+    auto age = clock->now().time_since_epoch() - std::chrono::nanoseconds{times.front()};
+    auto wall = std::chrono::system_clock::now() - age;
+    putVarint(raw, std::chrono::duration_cast<std::chrono::milliseconds>(wall.time_since_epoch()).count());
+
+    // ms resolution; producers race for the ring, so a sample a bit older than
+    // its predecessor is put on the predecessor's ms
+    std::int64_t prev = times.front() / 1000000;
+    for(auto time: times) {
+        auto ms = time / 1000000;
+        putVarint(raw, static_cast<std::uint64_t>(std::max<std::int64_t>(ms - prev, 0)));
+        prev = std::max(prev, ms);
+    }
+    for(auto kind: kinds) {
+        raw.push_back(static_cast<std::uint8_t>(kind));
+    }
+    raw.insert(raw.end(), ids.begin(), ids.end());
+    for(auto value: values) {
+        putVarint(raw, zigzag(value));
+    }
+}
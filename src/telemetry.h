@@ -0,0 +1,170 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <moba-common/ini.h>
+
+#include "moba/endpoint.h"
+
+#include "clock.h"
+#include "mpscring.h"
+
+/**
+ * Collects samples (input edges, output transitions, curtain positions,
+ * error counters) into a columnar batch and sends it zlib compressed as one
+ * EnvTelemetryBatch message, every interval or as soon as the batch is full.
+ * Configured in section [telemetry]:
+ *   interval=<ms>
+ *   batch=<samples>
+ *   level=<zlib level 1..9>
+ *
+ * Uncompressed batch layout, all integers unsigned LEB128 varints unless
+ * noted, each column holds count entries:
+ *   version (1 byte, 1), count, wall clock ms since the epoch of sample 0
+ *   time:  ms since the previous sample
+ *   kind:  1 byte each, see Kind
+ *   id:    1 byte each, pin number or Counter
+ *   value: zigzag varint
+ */
+class Telemetry final {
+public:
+    // EnvTelemetryBatch, group ENVIRONMENT; not part of lib-msghandling (yet)
+    static constexpr std::uint32_t BATCH_MESSAGE_ID = 16;
+    static constexpr std::uint8_t FORMAT_VERSION = 1;
+
+    enum class Kind: std::uint8_t {
+        INPUT_EDGE  = 0,  // id: pin, value: level
+        OUTPUT      = 1,  // id: pin, value: level
+        CURTAIN_POS = 2,  // value: position
+        COUNTER     = 3,  // id: Counter, value: total, only sent when it changed
+        PWM         = 4,  // id: pin, value: brightness the pattern settles at (peak if looped), permille
+    };
+
+    enum class Counter: std::uint8_t {
+        WATCHDOG_STALLS   = 0,
+        SOUND_DROPPED     = 1,
+        TELEMETRY_DROPPED = 2,
+        HEAP_AFTER_INIT   = 3,
+        JOBS_REJECTED     = 4,
+        LIGHT_FAILURES    = 5,
+    };
+
+    struct Stats {
+        unsigned int batches;
+        std::uint64_t samples;
+        // ring full or batch not sent, the sample is lost
+        std::uint64_t dropped;
+        // batches lost because sending failed (not connected)
+        unsigned int unsent;
+        std::uint64_t rawBytes;
+        std::uint64_t compressedBytes;
+    };
+
+    /**
+     * endpoint may be null (simulation), batches are built but dropped then
+     */
+    Telemetry(EndpointPtr endpoint, moba::IniPtr ini, ClockPtr clock);
+    ~Telemetry() noexcept;
+
+    Telemetry(const Telemetry&) = delete;
+    Telemetry& operator=(const Telemetry&) = delete;
+
+    /**
+     * Starts the telemetry thread; samples recorded before wait in the ring.
+     */
+    void start();
+
+    /**
+     * Lock free, from any thread.
+     */
+    void record(Kind kind, std::uint8_t id, std::int32_t value);
+
+    /**
+     * read is called in the telemetry thread once per batch.
+     */
+    void addCounter(Counter id, std::function<std::uint64_t()> read);
+
+    /**
+     * Sends what is left and joins the telemetry thread.
+     */
+    void stop();
+
+    Stats getStats();
+
+private:
+    struct Sample {
+        // ns since clock epoch
+        std::int64_t time;
+        Kind kind;
+        std::uint8_t id;
+        std::int32_t value;
+    };
+
+    struct CounterSource {
+        Counter id;
+        std::function<std::uint64_t()> read;
+        std::uint64_t last;
+    };
+
+    static constexpr std::chrono::milliseconds COLLECT_INTERVAL{100};
+
+    void collect();
+    void drain();
+    void append(const Sample &sample);
+    void sampleCounters();
+    void flush();
+    void encode();
+
+    EndpointPtr endpoint;
+    ClockPtr clock;
+
+    Clock::Duration interval;
+    std::size_t batchSize;
+    int level;
+
+    MpscRing<Sample, 4096> ring;
+    std::atomic<std::uint64_t> dropped{0};
+
+    // telemetry thread only, reserved for batchSize up front
+    std::vector<std::int64_t> times;
+    std::vector<Kind> kinds;
+    std::vector<std::uint8_t> ids;
+    std::vector<std::int32_t> values;
+    std::vector<std::uint8_t> raw;
+    std::vector<std::uint8_t> compressed;
+
+    std::mutex m;
+    std::vector<CounterSource> counters;
+    Stats stats{0, 0, 0, 0, 0, 0};
+
+    std::atomic<bool> running{true};
+    std::thread collectThread;
+};
+
+using TelemetryPtr = std::shared_ptr<Telemetry>;
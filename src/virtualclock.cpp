@@ -0,0 +1,169 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "virtualclock.h"
+
+#include <stdexcept>
+
+namespace {
+    thread_local const VirtualClock *participantOf = nullptr;
+}
+
+VirtualClock::TimePoint VirtualClock::now() {
+    std::lock_guard<std::mutex> l{m};
+    return current;
+}
+
+void VirtualClock::sleepFor(Duration d) {
+    if(participantOf != this) {
+        advanceTo(now() + d);
+        return;
+    }
+
+    std::unique_lock<std::mutex> l{m};
+    if(released) {
+        return;
+    }
+
+    auto wakeAt = current + d;
+    if(advancing && wakeAt <= target && (sleepers.empty() || wakeAt < sleepers.begin()->first.first)) {
+        current = wakeAt;
+        return;
+    }
+
+    thread_local std::condition_variable wake;
+
+    auto seq = nextSeq++;
+    sleepers.emplace(Ticket{wakeAt, seq}, &wake);
+    ++sleeping;
+    idle.notify_all();
+
+    wake.wait(l, [this, seq]{return released || wakeSeq == seq;});
+}
+
+void VirtualClock::sleepFor(Duration d, Alarm &alarm) {
+    if(participantOf != this) {
+        advanceTo(now() + d);
+        return;
+    }
+
+    std::unique_lock<std::mutex> l{m};
+    if(released || std::exchange(alarm.signaled, false)) {
+        return;
+    }
+
+    auto wakeAt = current + d;
+    if(advancing && wakeAt <= target && (sleepers.empty() || wakeAt < sleepers.begin()->first.first)) {
+        current = wakeAt;
+        return;
+    }
+
+    thread_local std::condition_variable wake;
+
+    alarm.sleeping = true;
+    alarm.wakeAt = wakeAt;
+    alarm.seq = nextSeq++;
+    sleepers.emplace(Ticket{wakeAt, alarm.seq}, &wake);
+    ++sleeping;
+    idle.notify_all();
+
+    // the seq changes if the alarm moves the ticket
+    wake.wait(l, [this, &alarm]{return released || wakeSeq == alarm.seq;});
+    alarm.sleeping = false;
+    alarm.signaled = false;
+}
+
+void VirtualClock::wake(Alarm &alarm) {
+    std::lock_guard<std::mutex> l{m};
+    alarm.signaled = true;
+    if(!alarm.sleeping || released) {
+        return;
+    }
+    auto iter = sleepers.find(Ticket{alarm.wakeAt, alarm.seq});
+    if(iter == sleepers.end() || alarm.wakeAt <= current) {
+        return;
+    }
+    auto cv = iter->second;
+    sleepers.erase(iter);
+    alarm.wakeAt = current;
+    alarm.seq = nextSeq++;
+    sleepers.emplace(Ticket{alarm.wakeAt, alarm.seq}, cv);
+}
+
+std::thread VirtualClock::startThread(std::function<void()> fn) {
+    std::unique_lock<std::mutex> l{m};
+    ++participants;
+
+    std::thread thread{[this, fn = std::move(fn)] {
+        participantOf = this;
+        fn();
+        std::lock_guard<std::mutex> l{m};
+        --participants;
+        idle.notify_all();
+    }};
+
+    // let the new thread run up to its first sleep, so threads get their tickets in start order
+    if(participantOf != this) {
+        waitIdle(l);
+    }
+    return thread;
+}
+
+void VirtualClock::advanceTo(TimePoint t) {
+    std::unique_lock<std::mutex> l{m};
+    waitIdle(l);
+
+    target = t;
+    advancing = true;
+    while(!released && !sleepers.empty() && sleepers.begin()->first.first <= t) {
+        auto [ticket, wake] = *sleepers.begin();
+        sleepers.erase(sleepers.begin());
+
+        current = std::max(current, ticket.first);
+        --sleeping;
+        wakeSeq = ticket.second;
+        wake->notify_one();
+
+        try {
+            waitIdle(l);
+        } catch(...) {
+            advancing = false;
+            throw;
+        }
+    }
+    advancing = false;
+    current = std::max(current, t);
+}
+
+void VirtualClock::release() {
+    std::lock_guard<std::mutex> l{m};
+    released = true;
+    for(auto &[ticket, wake]: sleepers) {
+        wake->notify_one();
+    }
+    sleepers.clear();
+    sleeping = 0;
+}
+
+void VirtualClock::waitIdle(std::unique_lock<std::mutex> &l) {
+    if(!idle.wait_for(l, STALL_TIMEOUT, [this]{return released || sleeping == participants;})) {
+        throw std::runtime_error{"simulation stalled: a participant blocks outside of sleepFor()"};
+    }
+}
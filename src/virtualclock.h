@@ -0,0 +1,100 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <utility>
+
+#include "clock.h"
+
+/**
+ * Deterministic clock for simulation. Threads started through startThread()
+ * are participants: virtual time only moves on (driven by advanceTo()) once
+ * every participant sleeps, and then exactly one sleeper - the earliest, ties
+ * in order of falling asleep - is woken at a time. So there is never more
+ * than one thread running, and a run only depends on its input.
+ *
+ * sleepFor() on any other thread (the driver) advances the clock itself.
+ *
+ * A participant blocking anywhere else than in sleepFor() stalls the
+ * simulation; advanceTo() throws after STALL_TIMEOUT of wall time.
+ *
+ * wake() moves a sleeper waiting on an alarm to the current time, it then
+ * runs at the next step, after everything else due now.
+ *
+ * A participant that would be the next one to wake up anyway doesn't hand
+ * over to the driver at all, it just moves the time on. Same result, but it
+ * saves the context switches for the short debounce sleeps.
+ */
+class VirtualClock final: public Clock {
+public:
+    static constexpr std::chrono::seconds STALL_TIMEOUT{10};
+
+    VirtualClock() = default;
+
+    VirtualClock(const VirtualClock&) = delete;
+    VirtualClock& operator=(const VirtualClock&) = delete;
+
+    TimePoint now() override;
+    void sleepFor(Duration d) override;
+    void sleepFor(Duration d, Alarm &alarm) override;
+    void wake(Alarm &alarm) override;
+    std::thread startThread(std::function<void()> fn) override;
+
+    /**
+     * Runs all participants until virtual time t.
+     */
+    void advanceTo(TimePoint t);
+
+    /**
+     * Stops virtual time, every sleepFor() returns immediately from now on.
+     * Needed before joining participants.
+     */
+    void release();
+
+private:
+    using Ticket = std::pair<TimePoint, std::uint64_t>;
+
+    void waitIdle(std::unique_lock<std::mutex> &l);
+
+    std::mutex m;
+    std::condition_variable idle;
+
+    TimePoint current{};
+
+    // set while advanceTo() runs
+    TimePoint target{};
+    bool advancing{false};
+
+    // each sleeper waits on its own condition variable, so a step wakes exactly one thread
+    std::map<Ticket, std::condition_variable*> sleepers;
+
+    std::size_t participants{0};
+    std::size_t sleeping{0};
+    std::uint64_t nextSeq{1};
+    std::uint64_t wakeSeq{0};
+    bool released{false};
+};
+
+using VirtualClockPtr = std::shared_ptr<VirtualClock>;
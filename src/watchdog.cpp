@@ -0,0 +1,165 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "watchdog.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <syslog.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+    std::int64_t toNs(Clock::TimePoint t) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+    }
+
+    double toMs(Clock::Duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    }
+}
+
+Watchdog::Heartbeat::Heartbeat(std::string name, Clock::Duration deadline, ClockPtr clock):
+name{std::move(name)}, deadline{deadline}, clock{clock} {
+}
+
+void Watchdog::Heartbeat::beat() {
+    auto now = clock->now();
+    last.store(toNs(now), std::memory_order_relaxed);
+    due.store(toNs(now + deadline), std::memory_order_release);
+}
+
+void Watchdog::Heartbeat::pause() {
+    due.store(0, std::memory_order_release);
+}
+
+Watchdog::Watchdog(BridgePtr bridge, moba::IniPtr ini, ClockPtr clock): bridge{bridge}, ini{ini}, clock{clock} {
+    checkInterval = std::chrono::milliseconds{ini->getInt("watchdog", "check_interval", 100)};
+    supervisorThread = clock->startThread([this]{supervise();});
+}
+
+Watchdog::~Watchdog() noexcept {
+    stop();
+}
+
+void Watchdog::stop() {
+    running = false;
+    if(supervisorThread.joinable()) {
+        supervisorThread.join();
+    }
+}
+
+Watchdog::HeartbeatPtr Watchdog::registerLoop(const std::string &name, std::chrono::milliseconds deadline) {
+    deadline = std::chrono::milliseconds{ini->getInt("watchdog", name, deadline.count())};
+    auto heartbeat = std::make_shared<Heartbeat>(name, deadline, clock);
+
+    std::lock_guard<std::mutex> l{m};
+    heartbeats.push_back(heartbeat);
+    return heartbeat;
+}
+
+Watchdog::Stats Watchdog::getStats() {
+    std::lock_guard<std::mutex> l{m};
+    return stats;
+}
+
+void Watchdog::supervise() {
+    while(running) {
+        if(check()) {
+            notifySystemd("WATCHDOG=1");
+        }
+        clock->sleepFor(checkInterval);
+    }
+}
+
+bool Watchdog::check() {
+    std::lock_guard<std::mutex> l{m};
+
+    auto now = toNs(clock->now());
+    bool healthy = true;
+    bool park = false;
+
+    for(auto &hb: heartbeats) {
+        auto due = hb->due.load(std::memory_order_acquire);
+
+        if(due == 0 || now <= due) {
+            if(hb->stalled) {
+                syslog(LOG_NOTICE, "watchdog: loop <%s> recovered", hb->name.c_str());
+                hb->stalled = false;
+            }
+            continue;
+        }
+
+        healthy = false;
+        if(hb->stalled) {
+            continue;
+        }
+        hb->stalled = true;
+        park = true;
+
+        auto detection = std::chrono::nanoseconds{now - hb->last.load(std::memory_order_relaxed)};
+        ++stats.stalls;
+        stats.lastDetectionTime = detection;
+        stats.maxDetectionTime = std::max(stats.maxDetectionTime, stats.lastDetectionTime);
+
+        syslog(
+            LOG_CRIT, "watchdog: loop <%s> stalled, no heartbeat for %.1f ms (deadline %.1f ms)",
+            hb->name.c_str(), toMs(detection), toMs(hb->deadline)
+        );
+    }
+
+    if(park) {
+        bridge->park();
+    }
+    return healthy;
+}
+
+void Watchdog::notifySystemd(const char *state) {
+    // sd_notify(), without pulling in libsystemd
+    auto socketPath = std::getenv("NOTIFY_SOCKET");
+    if(socketPath == nullptr || socketPath[0] == '\0') {
+        return;
+    }
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    auto len = std::strlen(socketPath);
+    if(len >= sizeof(addr.sun_path)) {
+        return;
+    }
+    std::memcpy(addr.sun_path, socketPath, len);
+    // abstract namespace
+    if(addr.sun_path[0] == '@') {
+        addr.sun_path[0] = '\0';
+    }
+
+    int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if(fd == -1) {
+        return;
+    }
+    sendto(
+        fd, state, std::strlen(state), MSG_NOSIGNAL, reinterpret_cast<sockaddr*>(&addr),
+        offsetof(sockaddr_un, sun_path) + len
+    );
+    close(fd);
+}
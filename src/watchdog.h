@@ -0,0 +1,126 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <moba-common/ini.h>
+
+#include "bridge.h"
+#include "clock.h"
+
+/**
+ * Supervises the control loops. Every loop registers a heartbeat and beats it
+ * at least once per deadline. The supervisor thread checks all heartbeats
+ * every check interval; a loop past its deadline counts as stalled: the
+ * outputs are parked and systemd is no longer fed (WATCHDOG=1), so systemd
+ * restarts the daemon unless the loop recovers in time.
+ *
+ * A stall is detected at most deadline + check interval after the last beat.
+ * Both are configurable in section [watchdog]:
+ *   check_interval=<ms>
+ *   <loop name>=<ms>    deadline of the loop
+ */
+class Watchdog final {
+public:
+    class Heartbeat final {
+    public:
+        Heartbeat(std::string name, Clock::Duration deadline, ClockPtr clock);
+
+        /**
+         * Lock free, may be called as often as needed.
+         */
+        void beat();
+
+        /**
+         * Takes the loop off supervision (e.g. while it legitimately
+         * waits), the next beat() puts it back.
+         */
+        void pause();
+
+    private:
+        friend class Watchdog;
+
+        const std::string name;
+        const Clock::Duration deadline;
+        ClockPtr clock;
+
+        // nanoseconds since clock epoch, 0: not supervised
+        std::atomic<std::int64_t> due{0};
+        std::atomic<std::int64_t> last{0};
+        bool stalled{false};
+    };
+
+    using HeartbeatPtr = std::shared_ptr<Heartbeat>;
+
+    struct Stats {
+        unsigned int stalls;
+        // time from the last beat of a loop until its stall was detected
+        Clock::Duration lastDetectionTime;
+        Clock::Duration maxDetectionTime;
+    };
+
+    Watchdog(BridgePtr bridge, moba::IniPtr ini, ClockPtr clock);
+    ~Watchdog() noexcept;
+
+    Watchdog(const Watchdog&) = delete;
+    Watchdog& operator=(const Watchdog&) = delete;
+
+    /**
+     * @param deadline default, overridden by [watchdog] <name>
+     */
+    HeartbeatPtr registerLoop(const std::string &name, std::chrono::milliseconds deadline);
+
+    /**
+     * Stops and joins the supervisor, systemd is no longer fed afterwards.
+     */
+    void stop();
+
+    Stats getStats();
+
+private:
+    void supervise();
+    bool check();
+
+    static void notifySystemd(const char *state);
+
+    BridgePtr bridge;
+    moba::IniPtr ini;
+    ClockPtr clock;
+
+    Clock::Duration checkInterval;
+
+    std::mutex m;
+    std::vector<HeartbeatPtr> heartbeats;
+    Stats stats{0, Clock::Duration::zero(), Clock::Duration::zero()};
+
+    std::atomic<bool> running{true};
+    std::thread supervisorThread;
+};
+
+using WatchdogPtr = std::shared_ptr<Watchdog>;
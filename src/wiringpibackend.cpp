@@ -0,0 +1,119 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "wiringpibackend.h"
+
+#include <softPwm.h>
+#include <syslog.h>
+#include <wiringPi.h>
+
+WiringPiBackend::WiringPiBackend(ClockPtr clock): clock{clock} {
+    wiringPiSetup();
+}
+
+void WiringPiBackend::setupOutput(int pin) {
+    std::lock_guard<std::mutex> l{m};
+    pinMode(pin, OUTPUT);
+}
+
+void WiringPiBackend::setupInput(int pin) {
+    std::lock_guard<std::mutex> l{m};
+    pinMode(pin, INPUT);
+}
+
+void WiringPiBackend::write(std::uint32_t highMask, std::uint32_t lowMask) {
+    std::lock_guard<std::mutex> l{m};
+    lowMask &= ~(hardwarePwm | softwarePwm);
+    highMask &= ~lowMask & ~(hardwarePwm | softwarePwm);
+    for(int pin = 0; highMask || lowMask; ++pin, highMask >>= 1, lowMask >>= 1) {
+        if(highMask & 1) {
+            digitalWrite(pin, HIGH);
+        } else if(lowMask & 1) {
+            digitalWrite(pin, LOW);
+        }
+    }
+}
+
+bool WiringPiBackend::read(int pin) {
+    std::lock_guard<std::mutex> l{m};
+    return digitalRead(pin);
+}
+
+int WiringPiBackend::pwmChannel(int pin) {
+    switch(pin) {
+        case 1:
+        case 26:
+            return 0;
+
+        case 23:
+        case 24:
+            return 1;
+
+        default:
+            return -1;
+    }
+}
+
+GpioBackend::Pwm WiringPiBackend::setupPwm(int pin) {
+    std::lock_guard<std::mutex> l{m};
+    if(!player) {
+        player = std::make_unique<PwmPlayer>(clock, [this](int pin, std::uint16_t duty) {
+            writeDuty(pin, duty);
+        });
+    }
+
+    auto channel = pwmChannel(pin);
+    if(channel != -1 && (channels[channel] == -1 || channels[channel] == pin)) {
+        if(channels[0] == -1 && channels[1] == -1) {
+            // shared by both channels
+            pwmSetMode(PWM_MODE_MS);
+            pwmSetRange(PwmPattern::FULL);
+            pwmSetClock(PWM_CLOCK_DIVISOR);
+        }
+        channels[channel] = pin;
+        pinMode(pin, PWM_OUTPUT);
+        pwmWrite(pin, 0);
+        hardwarePwm |= 1u << pin;
+        syslog(LOG_INFO, "pin <%d>: hardware PWM channel <%d>", pin, channel);
+        return Pwm::HARDWARE;
+    }
+    if(softPwmCreate(pin, 0, 100) != 0) {
+        syslog(LOG_ERR, "pin <%d>: no software PWM", pin);
+        return Pwm::NONE;
+    }
+    softwarePwm |= 1u << pin;
+    syslog(LOG_INFO, "pin <%d>: software PWM", pin);
+    return Pwm::SOFTWARE;
+}
+
+void WiringPiBackend::playPwm(int pin, const PwmPattern &pattern) {
+    if(player) {
+        player->play(pin, pattern);
+    }
+}
+
+void WiringPiBackend::writeDuty(int pin, std::uint16_t duty) {
+    std::lock_guard<std::mutex> l{m};
+    if(hardwarePwm & (1u << pin)) {
+        pwmWrite(pin, duty);
+    } else if(softwarePwm & (1u << pin)) {
+        softPwmWrite(pin, (duty + 5) / 10);
+    }
+}
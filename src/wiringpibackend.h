@@ -0,0 +1,73 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+
+#include "gpiobackend.h"
+#include "pwmplayer.h"
+
+/**
+ * PWM runs on the two hardware channels where a pin has one (wiringPi 1 and
+ * 26 on PWM0, 23 and 24 on PWM1; about 1 kHz, 1000 steps), one pin per
+ * channel. Any other output gets wiringPi's softPwm (100 Hz, 100 steps,
+ * a thread per pin). Patterns are played by a PwmPlayer.
+ */
+class WiringPiBackend final: public GpioBackend {
+public:
+    /**
+     * @param clock times the PWM patterns
+     */
+    explicit WiringPiBackend(ClockPtr clock);
+
+    WiringPiBackend(const WiringPiBackend&) = delete;
+    WiringPiBackend& operator=(const WiringPiBackend&) = delete;
+
+    void setupOutput(int pin) override;
+    void setupInput(int pin) override;
+
+    void write(std::uint32_t highMask, std::uint32_t lowMask) override;
+    bool read(int pin) override;
+
+    Pwm setupPwm(int pin) override;
+    void playPwm(int pin, const PwmPattern &pattern) override;
+
+private:
+    // 19.2 MHz / 19 / 1000
+    static constexpr int PWM_CLOCK_DIVISOR = 19;
+
+    /**
+     * @return -1 if the pin has no hardware channel
+     */
+    static int pwmChannel(int pin);
+
+    void writeDuty(int pin, std::uint16_t duty);
+
+    std::mutex m;
+    ClockPtr clock;
+
+    std::uint32_t hardwarePwm{0};
+    std::uint32_t softwarePwm{0};
+    // pin per channel, -1: free
+    int channels[2]{-1, -1};
+    std::unique_ptr<PwmPlayer> player;
+};
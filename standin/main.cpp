@@ -0,0 +1,177 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include "moba/clientmessages.h"
+#include "moba/systemmessages.h"
+
+#include "recorder.h"
+#include "server.h"
+#include "stream.h"
+
+/*
+ * Stands in for the central message server: waits for the daemon on a TCP
+ * port, plays a scripted or a random message stream to it at a controlled
+ * rate and reports throughput, reaction latency and reconnect behaviour.
+ * Point the daemon at it with host=<this host>:<port> in its config.
+ *
+ *   moba-environment-standin [--port=7000] [--record=<file>] [--settle=<duration>]
+ *       (--script=<file> [--speed=<x>] | --rate=<msgs/s> --duration=<duration> [--seed=<n>] [--drop-every=<duration>])
+ *
+ * The stream starts with the first connection. --settle keeps listening
+ * after the last message, long enough for the daemon's last telemetry batch
+ * (its [telemetry] interval) to arrive; reaction latency needs telemetry.
+ */
+
+namespace {
+    [[noreturn]] void usage(const char *name) {
+        std::fprintf(
+            stderr,
+            "usage: %s [--port=7000] [--record=<file>] [--settle=<duration>]\n"
+            "    (--script=<file> [--speed=<x>] | --rate=<msgs/s> --duration=<duration> [--seed=<n>] [--drop-every=<duration>])\n",
+            name
+        );
+        std::exit(EXIT_FAILURE);
+    }
+
+    // the app id handed out on ClientStart
+    constexpr int APP_ID = 1;
+}
+
+int main(const int argc, char *argv[]) {
+    int port = 7000;
+    std::string recordFile;
+    std::string script;
+    double speed = 1.0;
+    double rate = 0.0;
+    std::chrono::milliseconds duration{0};
+    std::chrono::milliseconds settle{6000};
+    std::chrono::milliseconds dropEvery{0};
+    std::uint64_t seed = 1;
+
+    try {
+        for(int i = 1; i < argc; ++i) {
+            std::string arg{argv[i]};
+            if(arg.starts_with("--port=")) {
+                port = std::stoi(arg.substr(7));
+            } else if(arg.starts_with("--record=")) {
+                recordFile = arg.substr(9);
+            } else if(arg.starts_with("--settle=")) {
+                settle = parseDuration(arg.substr(9));
+            } else if(arg.starts_with("--script=")) {
+                script = arg.substr(9);
+            } else if(arg.starts_with("--speed=")) {
+                speed = std::stod(arg.substr(8));
+            } else if(arg.starts_with("--rate=")) {
+                rate = std::stod(arg.substr(7));
+            } else if(arg.starts_with("--duration=")) {
+                duration = parseDuration(arg.substr(11));
+            } else if(arg.starts_with("--seed=")) {
+                seed = std::stoull(arg.substr(7));
+            } else if(arg.starts_with("--drop-every=")) {
+                dropEvery = parseDuration(arg.substr(13));
+            } else {
+                usage(argv[0]);
+            }
+        }
+    } catch(const std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        usage(argv[0]);
+    }
+
+    if(script.empty() == (rate <= 0.0) || speed <= 0.0 || (rate > 0.0 && duration.count() <= 0)) {
+        usage(argv[0]);
+    }
+
+    try {
+        auto stream = script.empty() ?
+            randomStream(rate, duration, seed, dropEvery) :
+            scriptedStream(loadScript(script), speed);
+
+        Recorder recorder{recordFile};
+        StandinServer server{port};
+
+        const char *hardwareState = StimulusEncoder::INITIAL_STATE;
+        bool dropping = false;
+
+        server.setConnectionHandler([&](bool connected) {
+            if(connected) {
+                recorder.connected();
+            } else {
+                recorder.dropped(dropping);
+            }
+        });
+        server.setFrameHandler([&](const StandinServer::Frame &frame) {
+            recorder.received(frame);
+            if(frame.groupId == ClientStart::GROUP_ID && frame.messageId == ClientStart::MESSAGE_ID) {
+                server.send(StimulusEncoder::connectedFrame(APP_ID));
+            } else if(
+                frame.groupId == SystemGetHardwareState::GROUP_ID && frame.messageId == SystemGetHardwareState::MESSAGE_ID
+            ) {
+                server.send(StimulusEncoder::hardwareStateFrame(hardwareState));
+            }
+        });
+
+        std::fprintf(stderr, "waiting for the daemon on port %d, %zu messages to send\n", port, stream.size());
+        while(!server.isConnected()) {
+            server.poll(std::chrono::milliseconds{1000});
+        }
+
+        auto pollUntil = [&server](std::chrono::steady_clock::time_point until) {
+            for(auto now = std::chrono::steady_clock::now(); now < until; now = std::chrono::steady_clock::now()) {
+                server.poll(std::min(
+                    std::chrono::ceil<std::chrono::milliseconds>(until - now), std::chrono::milliseconds{100}
+                ));
+            }
+        };
+
+        auto start = std::chrono::steady_clock::now();
+        for(const auto &stimulus: stream) {
+            pollUntil(start + stimulus.time);
+            if(stimulus.hardwareState) {
+                hardwareState = stimulus.hardwareState;
+            }
+            if(stimulus.disconnect) {
+                dropping = true;
+                server.drop();
+                dropping = false;
+                continue;
+            }
+            if(server.send(stimulus.frame)) {
+                recorder.sent(stimulus);
+            } else {
+                recorder.lost(stimulus);
+            }
+        }
+        pollUntil(std::chrono::steady_clock::now() + settle);
+
+        recorder.report(stdout);
+    } catch(const std::exception &e) {
+        std::fprintf(stderr, "stand-in failed: %s\n", e.what());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
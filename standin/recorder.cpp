@@ -0,0 +1,275 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "recorder.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <zlib.h>
+
+#include "moba/environmentmessages.h"
+#include "moba/systemmessages.h"
+
+#include "telemetry.h"
+
+namespace {
+    /**
+     * @param p percentile in [0, 1], sorts the samples
+     */
+    double percentile(std::vector<double> &samples, double p) {
+        if(samples.empty()) {
+            return 0.0;
+        }
+        std::sort(samples.begin(), samples.end());
+        return samples[static_cast<std::size_t>(p * (samples.size() - 1))];
+    }
+
+    std::vector<std::uint8_t> fromBase64(const std::string &in) {
+        std::vector<std::uint8_t> out;
+        out.reserve(in.size() / 4 * 3);
+        std::uint32_t n = 0;
+        int bits = 0;
+        for(char c: in) {
+            int v;
+            if(c >= 'A' && c <= 'Z') {
+                v = c - 'A';
+            } else if(c >= 'a' && c <= 'z') {
+                v = c - 'a' + 26;
+            } else if(c >= '0' && c <= '9') {
+                v = c - '0' + 52;
+            } else if(c == '+') {
+                v = 62;
+            } else if(c == '/') {
+                v = 63;
+            } else if(c == '=') {
+                break;
+            } else {
+                throw std::runtime_error{"invalid base64"};
+            }
+            n = (n << 6) | v;
+            bits += 6;
+            if(bits >= 8) {
+                bits -= 8;
+                out.push_back(static_cast<std::uint8_t>(n >> bits));
+            }
+        }
+        return out;
+    }
+
+    class Reader {
+    public:
+        explicit Reader(const std::vector<std::uint8_t> &data): data{data} {
+        }
+
+        std::uint8_t byte() {
+            if(pos == data.size()) {
+                throw std::runtime_error{"batch truncated"};
+            }
+            return data[pos++];
+        }
+
+        std::uint64_t varint() {
+            std::uint64_t v = 0;
+            for(int shift = 0; shift < 64; shift += 7) {
+                auto b = byte();
+                v |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+                if(!(b & 0x80)) {
+                    return v;
+                }
+            }
+            throw std::runtime_error{"invalid varint"};
+        }
+
+        std::int32_t zigzag() {
+            auto v = static_cast<std::uint32_t>(varint());
+            return static_cast<std::int32_t>((v >> 1) ^ -(v & 1));
+        }
+
+    private:
+        const std::vector<std::uint8_t> &data;
+        std::size_t pos{0};
+    };
+}
+
+Recorder::Recorder(const std::string &fileName): start{std::chrono::steady_clock::now()} {
+    if(fileName.empty()) {
+        return;
+    }
+    file.open(fileName);
+    if(!file) {
+        throw std::runtime_error{"unable to write <" + fileName + ">"};
+    }
+}
+
+double Recorder::nowMs() {
+    return std::chrono::duration<double, std::milli>(WallClock::now().time_since_epoch()).count();
+}
+
+void Recorder::sent(const Stimulus &stimulus) {
+    auto now = nowMs();
+    if(!firstSent) {
+        firstSent = now;
+    }
+    lastSent = now;
+    ++sentCount;
+    write('>', stimulus.frame);
+    if(stimulus.pin != -1) {
+        pending.push_back({now, stimulus.pin, stimulus.level});
+    }
+}
+
+void Recorder::lost(const Stimulus&) {
+    ++lostCount;
+}
+
+void Recorder::received(const StandinServer::Frame &frame) {
+    ++receivedCount;
+    write('<', frame);
+
+    if(frame.groupId == SystemGetHardwareState::GROUP_ID && frame.messageId == SystemGetHardwareState::MESSAGE_ID) {
+        if(awaitingResync) {
+            resyncs.push_back(nowMs() - droppedAt);
+        }
+        awaitingResync = false;
+    } else if(frame.groupId == EnvironmentMessage::GROUP_ID && frame.messageId == Telemetry::BATCH_MESSAGE_ID) {
+        try {
+            decodeBatch(frame.payload);
+            ++batches;
+        } catch(const std::exception &e) {
+            std::fprintf(stderr, "telemetry batch not decoded: %s\n", e.what());
+            ++badBatches;
+        }
+    }
+}
+
+void Recorder::connected() {
+    write("connected");
+    if(awaitingReconnect) {
+        reconnects.push_back(nowMs() - droppedAt);
+    }
+    awaitingReconnect = false;
+}
+
+void Recorder::dropped(bool byUs) {
+    write(byUs ? "dropped" : "lost");
+    if(!byUs) {
+        ++lostByDaemon;
+        return;
+    }
+    droppedAt = nowMs();
+    awaitingReconnect = true;
+    awaitingResync = true;
+}
+
+void Recorder::write(char direction, const StandinServer::Frame &frame) {
+    if(!file.is_open()) {
+        return;
+    }
+    auto t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    file << std::fixed << t << ' ' << direction << ' ' << frame.groupId << '.' << frame.messageId << ' ' << frame.payload << '\n';
+}
+
+void Recorder::write(const char *event) {
+    if(!file.is_open()) {
+        return;
+    }
+    auto t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    file << std::fixed << t << " - " << event << '\n';
+}
+
+void Recorder::decodeBatch(const std::string &payload) {
+    auto d = nlohmann::json::parse(payload);
+    auto compressed = fromBase64(d["data"].get<std::string>());
+    std::vector<std::uint8_t> raw(d["rawSize"].get<std::size_t>());
+
+    uLongf size = raw.size();
+    if(uncompress(raw.data(), &size, compressed.data(), compressed.size()) != Z_OK || size != raw.size()) {
+        throw std::runtime_error{"uncompress failed"};
+    }
+
+    Reader in{raw};
+    if(in.byte() != Telemetry::FORMAT_VERSION) {
+        throw std::runtime_error{"unknown version"};
+    }
+    auto count = in.varint();
+    auto base = static_cast<std::int64_t>(in.varint());
+
+    std::vector<std::int64_t> times(count);
+    std::vector<std::uint8_t> kinds(count);
+    std::vector<std::uint8_t> ids(count);
+    for(auto &t: times) {
+        base += static_cast<std::int64_t>(in.varint());
+        t = base;
+    }
+    for(auto &k: kinds) {
+        k = in.byte();
+    }
+    for(auto &i: ids) {
+        i = in.byte();
+    }
+    for(std::size_t i = 0; i < count; ++i) {
+        auto value = in.zigzag();
+        if(kinds[i] == static_cast<std::uint8_t>(Telemetry::Kind::OUTPUT)) {
+            onOutput(times[i], ids[i], value != 0);
+        }
+    }
+}
+
+void Recorder::onOutput(std::int64_t time, int pin, bool level) {
+    // the daemon's samples are rounded down to the ms
+    auto answers = [&](const Pending &p) {
+        return p.pin == pin && p.level == level && p.sent <= time + 1;
+    };
+    auto latest = std::find_if(pending.rbegin(), pending.rend(), answers);
+    if(latest == pending.rend()) {
+        return;
+    }
+    reactions.push_back(std::max(time - latest->sent, 0.0));
+    superseded += std::erase_if(pending, answers) - 1;
+}
+
+void Recorder::report(std::FILE *out) {
+    auto line = [out](const char *name, double value, const char *unit) {
+        std::fprintf(out, "%-40s %14.1f %s\n", name, value, unit);
+    };
+    auto duration = firstSent ? (*lastSent - *firstSent) / 1000.0 : 0.0;
+
+    line("stream.sent", sentCount, "msgs");
+    line("stream.duration", duration, "s");
+    line("stream.throughput", duration > 0 ? sentCount / duration : 0.0, "msgs/s");
+    line("stream.lost", lostCount, "msgs");
+    line("replies.received", receivedCount, "msgs");
+    line("replies.telemetry", batches, "batches");
+    if(badBatches) {
+        line("replies.telemetry.invalid", badBatches, "batches");
+    }
+    line("reaction.matched", reactions.size(), "msgs");
+    line("reaction.p50", percentile(reactions, 0.50), "ms");
+    line("reaction.p99", percentile(reactions, 0.99), "ms");
+    line("reaction.max", percentile(reactions, 1.00), "ms");
+    line("reaction.superseded", superseded, "msgs");
+    line("reaction.unanswered", pending.size(), "msgs");
+    line("reconnect.count", reconnects.size(), "");
+    line("reconnect.p50", percentile(reconnects, 0.50), "ms");
+    line("reconnect.max", percentile(reconnects, 1.00), "ms");
+    line("reconnect.resync.p50", percentile(resyncs, 0.50), "ms");
+    line("reconnect.lost_by_daemon", lostByDaemon, "");
+    std::fflush(out);
+}
@@ -0,0 +1,117 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "server.h"
+#include "stream.h"
+
+/**
+ * Keeps what went over the connection and what came of it. Frames are
+ * written to the record file, if any, one per line:
+ *
+ *   <seconds> > <group>.<message> <payload>     sent to the daemon
+ *   <seconds> < <group>.<message> <payload>     from the daemon
+ *   <seconds> - connected|dropped|lost
+ *
+ * Reaction latency is taken from the OUTPUT samples of the daemon's
+ * telemetry batches: the first transition of the expected pin to the
+ * expected level at or after a stimulus was sent. The samples carry the
+ * wall clock of the daemon in ms, so both hosts need a common clock (the
+ * same host or NTP); a stimulus answered by the same transition as a later
+ * one is counted as superseded.
+ */
+class Recorder final {
+public:
+    /**
+     * @param fileName empty for no record file
+     * @throws std::runtime_error if the file can not be written
+     */
+    explicit Recorder(const std::string &fileName);
+
+    Recorder(const Recorder&) = delete;
+    Recorder& operator=(const Recorder&) = delete;
+
+    void sent(const Stimulus &stimulus);
+
+    /**
+     * Not connected when it was due.
+     */
+    void lost(const Stimulus &stimulus);
+
+    void received(const StandinServer::Frame &frame);
+
+    void connected();
+
+    /**
+     * @param byUs false if the daemon closed the connection
+     */
+    void dropped(bool byUs);
+
+    void report(std::FILE *out);
+
+private:
+    using WallClock = std::chrono::system_clock;
+
+    struct Pending {
+        // ms since the epoch
+        double sent;
+        int pin;
+        bool level;
+    };
+
+    void write(char direction, const StandinServer::Frame &frame);
+    void write(const char *event);
+    void decodeBatch(const std::string &payload);
+    void onOutput(std::int64_t time, int pin, bool level);
+
+    static double nowMs();
+
+    std::ofstream file;
+    std::chrono::steady_clock::time_point start;
+
+    std::optional<double> firstSent;
+    std::optional<double> lastSent;
+    std::uint64_t sentCount{0};
+    std::uint64_t lostCount{0};
+    std::uint64_t receivedCount{0};
+    std::uint64_t batches{0};
+    std::uint64_t badBatches{0};
+
+    std::vector<Pending> pending;
+    std::vector<double> reactions;
+    std::uint64_t superseded{0};
+
+    // the last drop by us, until the daemon is back and has asked for the hardware state
+    double droppedAt{0};
+    bool awaitingReconnect{false};
+    bool awaitingResync{false};
+    std::vector<double> reconnects;
+    std::vector<double> resyncs;
+    std::uint64_t lostByDaemon{0};
+};
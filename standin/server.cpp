@@ -0,0 +1,181 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "server.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+    std::uint32_t getU32(const char *p) {
+        std::uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return ntohl(v);
+    }
+
+    void putU32(char *p, std::uint32_t v) {
+        v = htonl(v);
+        std::memcpy(p, &v, sizeof(v));
+    }
+}
+
+StandinServer::StandinServer(int port) {
+    listenFd = ::socket(AF_INET6, SOCK_STREAM, 0);
+    if(listenFd == -1) {
+        throw std::runtime_error{std::string{"socket: "} + std::strerror(errno)};
+    }
+    int on = 1;
+    ::setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    // IPv4 clients as well
+    int off = 0;
+    ::setsockopt(listenFd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+
+    sockaddr_in6 addr{};
+    addr.sin6_family = AF_INET6;
+    addr.sin6_addr = in6addr_any;
+    addr.sin6_port = htons(static_cast<std::uint16_t>(port));
+    if(::bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1 || ::listen(listenFd, 1) == -1) {
+        auto err = std::string{"bind / listen on port "} + std::to_string(port) + ": " + std::strerror(errno);
+        ::close(listenFd);
+        throw std::runtime_error{err};
+    }
+}
+
+StandinServer::~StandinServer() noexcept {
+    if(fd != -1) {
+        ::close(fd);
+    }
+    ::close(listenFd);
+}
+
+void StandinServer::setFrameHandler(FrameHandler handler) {
+    frameHandler = std::move(handler);
+}
+
+void StandinServer::setConnectionHandler(ConnectionHandler handler) {
+    connectionHandler = std::move(handler);
+}
+
+void StandinServer::poll(std::chrono::milliseconds timeout) {
+    pollfd pfd{isConnected() ? fd : listenFd, POLLIN, 0};
+    if(::poll(&pfd, 1, static_cast<int>(std::max<std::int64_t>(timeout.count(), 0))) <= 0) {
+        return;
+    }
+    if(isConnected()) {
+        readClient();
+    } else {
+        acceptClient();
+    }
+}
+
+bool StandinServer::send(const Frame &frame) {
+    if(!isConnected()) {
+        return false;
+    }
+    std::string data(HEADER_SIZE, '\0');
+    putU32(data.data(), frame.groupId);
+    putU32(data.data() + 4, frame.messageId);
+    putU32(data.data() + 8, static_cast<std::uint32_t>(frame.payload.size()));
+    data += frame.payload;
+
+    for(std::size_t sent = 0; sent < data.size();) {
+        auto n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if(n == -1 && errno == EINTR) {
+            continue;
+        }
+        if(n <= 0) {
+            close();
+            return false;
+        }
+        sent += n;
+    }
+    return true;
+}
+
+void StandinServer::drop() {
+    if(isConnected()) {
+        close();
+    }
+}
+
+void StandinServer::acceptClient() {
+    fd = ::accept(listenFd, nullptr, nullptr);
+    if(fd == -1) {
+        return;
+    }
+    int on = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    buffer.clear();
+    if(connectionHandler) {
+        connectionHandler(true);
+    }
+}
+
+void StandinServer::readClient() {
+    char chunk[64 * 1024];
+    auto n = ::recv(fd, chunk, sizeof(chunk), 0);
+    if(n == -1 && errno == EINTR) {
+        return;
+    }
+    if(n <= 0) {
+        close();
+        return;
+    }
+    buffer.append(chunk, n);
+
+    std::size_t pos = 0;
+    while(buffer.size() - pos >= HEADER_SIZE) {
+        auto size = getU32(buffer.data() + pos + 8);
+        if(size > MAX_PAYLOAD) {
+            close();
+            return;
+        }
+        if(buffer.size() - pos - HEADER_SIZE < size) {
+            break;
+        }
+        Frame frame{getU32(buffer.data() + pos), getU32(buffer.data() + pos + 4), buffer.substr(pos + HEADER_SIZE, size)};
+        pos += HEADER_SIZE + size;
+        if(frameHandler) {
+            frameHandler(frame);
+        }
+        // the handler may have dropped the connection
+        if(!isConnected()) {
+            return;
+        }
+    }
+    buffer.erase(0, pos);
+}
+
+void StandinServer::close() {
+    ::close(fd);
+    fd = -1;
+    buffer.clear();
+    if(connectionHandler) {
+        connectionHandler(false);
+    }
+}
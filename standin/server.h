@@ -0,0 +1,96 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+/**
+ * Listens for the daemon on a TCP port, one connection at a time. Frames as
+ * lib-msghandling's Socket puts them on the wire: group id, message id and
+ * payload length as 32 bit big endian, then the JSON payload.
+ *
+ * Single threaded: poll() accepts, reads and hands out complete frames, so
+ * the caller can interleave sending at its own pace.
+ */
+class StandinServer final {
+public:
+    struct Frame {
+        std::uint32_t groupId;
+        std::uint32_t messageId;
+        std::string payload;
+    };
+
+    using FrameHandler = std::function<void(const Frame&)>;
+
+    // true: connected, false: the connection is gone
+    using ConnectionHandler = std::function<void(bool)>;
+
+    /**
+     * @throws std::runtime_error if the port can not be bound
+     */
+    explicit StandinServer(int port);
+    ~StandinServer() noexcept;
+
+    StandinServer(const StandinServer&) = delete;
+    StandinServer& operator=(const StandinServer&) = delete;
+
+    void setFrameHandler(FrameHandler handler);
+    void setConnectionHandler(ConnectionHandler handler);
+
+    /**
+     * Waits up to timeout for a connection or data and handles whatever
+     * arrived.
+     */
+    void poll(std::chrono::milliseconds timeout);
+
+    /**
+     * @return false if not connected or the connection broke
+     */
+    bool send(const Frame &frame);
+
+    /**
+     * Closes the connection, the daemon has to reconnect.
+     */
+    void drop();
+
+    bool isConnected() const {
+        return fd != -1;
+    }
+
+private:
+    static constexpr std::size_t HEADER_SIZE = 12;
+    // anything bigger is taken for garbage and drops the connection
+    static constexpr std::uint32_t MAX_PAYLOAD = 16 * 1024 * 1024;
+
+    void acceptClient();
+    void readClient();
+    void close();
+
+    int listenFd{-1};
+    int fd{-1};
+    std::string buffer;
+
+    FrameHandler frameHandler;
+    ConnectionHandler connectionHandler;
+};
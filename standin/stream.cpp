@@ -0,0 +1,245 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include "stream.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+
+#include "moba/clientmessages.h"
+#include "moba/environmentmessages.h"
+#include "moba/systemmessages.h"
+#include "moba/timermessages.h"
+
+#include "bridge.h"
+
+namespace {
+    struct HardwareStateName {
+        const char *name;
+        // status bar red, green otherwise
+        bool red;
+    };
+
+    constexpr HardwareStateName HARDWARE_STATES[] = {
+        {"ERROR",          true},
+        {"STANDBY",        false},
+        {"EMERGENCY_STOP", true},
+        {"MANUEL",         false},
+        {"AUTOMATIC",      false},
+    };
+
+    const HardwareStateName *findState(const std::string &name) {
+        for(const auto &s: HARDWARE_STATES) {
+            if(name == s.name) {
+                return &s;
+            }
+        }
+        return nullptr;
+    }
+
+    const char *toToggleState(std::optional<bool> v) {
+        if(!v) {
+            return "UNSET";
+        }
+        return *v ? "ON" : "OFF";
+    }
+
+    std::optional<bool> parseToggle(const std::string &val) {
+        if(val == "on") {
+            return true;
+        }
+        if(val == "off") {
+            return false;
+        }
+        throw std::runtime_error{"expected on or off, got <" + val + ">"};
+    }
+}
+
+Stimulus StimulusEncoder::hardware(std::chrono::microseconds time, const std::string &name) {
+    auto next = findState(name);
+    if(!next) {
+        throw std::runtime_error{"unknown hardware state <" + name + ">"};
+    }
+    auto prev = findState(state);
+    state = next->name;
+    if(!eclipsed && std::string_view{state} == "AUTOMATIC") {
+        eclipsed = true;
+        lightBeforeEclipse = light;
+        if(light) {
+            light = false;
+        }
+    } else if(eclipsed && std::string_view{state} == "MANUEL") {
+        eclipsed = false;
+        if(!lightBeforeEclipse) {
+            light.reset();
+        } else if(*lightBeforeEclipse) {
+            light = true;
+        }
+    }
+
+    Stimulus s{time, "hardware", hardwareStateFrame(state), false, state, -1, true};
+    // only a change of colour is sure to switch a led, the blink patterns of one colour differ in timing only
+    if(prev->red != next->red) {
+        s.pin = next->red ? Bridge::STATUS_RED : Bridge::STATUS_GREEN;
+    }
+    return s;
+}
+
+Stimulus StimulusEncoder::ambience(std::chrono::microseconds time, std::optional<bool> curtainUp, std::optional<bool> lightOn) {
+    nlohmann::json d;
+    d["curtainUp"] = std::string{toToggleState(curtainUp)};
+    d["mainLightOn"] = std::string{toToggleState(lightOn)};
+
+    Stimulus s{time, "ambience", {EnvSetAmbience::GROUP_ID, EnvSetAmbience::MESSAGE_ID, d.dump()}, false, nullptr, -1, true};
+    if(!lightOn) {
+        return s;
+    }
+    // an impulse relay: any switch is a pulse, unknown is taken for a switch
+    if(light != lightOn) {
+        s.pin = Bridge::MAIN_LIGHT;
+    }
+    light = lightOn;
+    return s;
+}
+
+Stimulus StimulusEncoder::timer(std::chrono::microseconds time, const std::string &modelTime, int multiplicator) {
+    nlohmann::json d;
+    d["curModelTime"] = modelTime;
+    d["multiplicator"] = multiplicator;
+    return {time, "timer", {TimerGlobalTimerEvent::GROUP_ID, TimerGlobalTimerEvent::MESSAGE_ID, d.dump()}, false, nullptr, -1, true};
+}
+
+Stimulus StimulusEncoder::error(std::chrono::microseconds time, const std::string &errorId, const std::string &text) {
+    nlohmann::json d;
+    d["errorId"] = errorId;
+    d["additionalMsg"] = text;
+    return {time, "error", {ClientError::GROUP_ID, ClientError::MESSAGE_ID, d.dump()}, false, nullptr, -1, true};
+}
+
+Stimulus StimulusEncoder::disconnect(std::chrono::microseconds time) {
+    return {time, "disconnect", {}, true, nullptr, -1, true};
+}
+
+StandinServer::Frame StimulusEncoder::hardwareStateFrame(const char *state) {
+    return {SystemHardwareStateChanged::GROUP_ID, SystemHardwareStateChanged::MESSAGE_ID, nlohmann::json(std::string{state}).dump()};
+}
+
+StandinServer::Frame StimulusEncoder::connectedFrame(int appId) {
+    return {ClientConnected::GROUP_ID, ClientConnected::MESSAGE_ID, nlohmann::json(appId).dump()};
+}
+
+std::vector<Stimulus> scriptedStream(const std::vector<ScriptEvent> &events, double speed) {
+    StimulusEncoder encoder;
+    std::vector<Stimulus> stream;
+
+    for(const auto &event: events) {
+        const auto &args = event.args;
+        const auto &cmd = event.command;
+        auto time = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::duration<double, std::micro>(std::chrono::microseconds{event.time}.count() / speed)
+        );
+        try {
+            if(cmd == "hardware" && args.size() == 1) {
+                stream.push_back(encoder.hardware(time, args[0]));
+            } else if(cmd == "ambience" && !args.empty()) {
+                std::optional<bool> curtainUp;
+                std::optional<bool> lightOn;
+                for(const auto &arg: args) {
+                    if(arg.starts_with("curtain=")) {
+                        curtainUp = parseToggle(arg.substr(8));
+                    } else if(arg.starts_with("light=")) {
+                        lightOn = parseToggle(arg.substr(6));
+                    } else {
+                        throw std::runtime_error{"invalid ambience argument <" + arg + ">"};
+                    }
+                }
+                stream.push_back(encoder.ambience(time, curtainUp, lightOn));
+            } else if(cmd == "timer" && (args.size() == 1 || args.size() == 2)) {
+                stream.push_back(encoder.timer(time, args[0], args.size() == 2 ? std::stoi(args[1]) : 1));
+            } else if(cmd == "error" && !args.empty()) {
+                std::string text;
+                for(std::size_t i = 1; i < args.size(); ++i) {
+                    text += (i > 1 ? " " : "") + args[i];
+                }
+                stream.push_back(encoder.error(time, args[0], text));
+            } else if(cmd == "disconnect" && args.empty()) {
+                stream.push_back(encoder.disconnect(time));
+            } else {
+                throw std::runtime_error{"invalid command <" + cmd + ">"};
+            }
+        } catch(const std::exception &e) {
+            throw std::runtime_error{"line " + std::to_string(event.line) + ": " + e.what()};
+        }
+    }
+    return stream;
+}
+
+std::vector<Stimulus> randomStream(
+    double rate, std::chrono::milliseconds duration, std::uint64_t seed, std::chrono::milliseconds dropEvery
+) {
+    StimulusEncoder encoder;
+    std::vector<Stimulus> stream;
+
+    std::mt19937_64 rng{seed};
+    std::exponential_distribution<double> gap{rate};
+    std::uniform_int_distribution<int> percent{0, 99};
+    std::uniform_int_distribution<int> states{0, std::size(HARDWARE_STATES) - 1};
+    std::bernoulli_distribution coin{0.5};
+
+    int modelMinutes = 6 * 60;
+    auto nextDrop = dropEvery;
+    std::chrono::duration<double, std::micro> t{0};
+    std::chrono::microseconds end = duration;
+
+    for(unsigned int n = 0;; ++n) {
+        t += std::chrono::duration<double>(gap(rng));
+        auto time = std::chrono::duration_cast<std::chrono::microseconds>(t);
+        if(time >= end) {
+            break;
+        }
+        while(dropEvery.count() && nextDrop <= time) {
+            stream.push_back(encoder.disconnect(nextDrop));
+            nextDrop += dropEvery;
+        }
+
+        auto p = percent(rng);
+        if(p < 60) {
+            // mostly the light, it has the most visible reaction
+            if(percent(rng) < 70) {
+                stream.push_back(encoder.ambience(time, std::nullopt, coin(rng)));
+            } else {
+                stream.push_back(encoder.ambience(time, coin(rng), std::nullopt));
+            }
+        } else if(p < 75) {
+            stream.push_back(encoder.hardware(time, HARDWARE_STATES[states(rng)].name));
+        } else if(p < 90) {
+            modelMinutes = (modelMinutes + 1) % (24 * 60);
+            char modelTime[8];
+            std::snprintf(modelTime, sizeof(modelTime), "%02d:%02d", modelMinutes / 60, modelMinutes % 60);
+            stream.push_back(encoder.timer(time, modelTime, 60));
+        } else {
+            stream.push_back(encoder.error(time, "STANDIN_LOAD", "message " + std::to_string(n)));
+        }
+    }
+    return stream;
+}
@@ -0,0 +1,118 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "script.h"
+#include "server.h"
+
+/**
+ * One message of the stream played to the daemon.
+ */
+struct Stimulus {
+    // since the start of the stream
+    std::chrono::microseconds time;
+    // hardware, ambience, timer, error or disconnect
+    const char *kind;
+    // none for a disconnect, the server drops the connection instead
+    StandinServer::Frame frame;
+    bool disconnect;
+    // the hardware state from now on, null if unchanged
+    const char *hardwareState;
+    // the output the daemon has to switch in reaction, -1 if it need not
+    int pin;
+    bool level;
+};
+
+/**
+ * Builds stimuli with payloads as lib-msghandling decodes them. Remembers
+ * what was requested before, so it can tell which output a message has to
+ * switch: a status led for a hardware state that changes the status colour,
+ * the main light relay for a light command that changes the light, in any
+ * hardware state. AUTOMATIC starts the eclipse, which switches the light
+ * off, MANUEL stops it and restores the light; those switches are tracked
+ * but not awaited, the hardware stimulus waits for its status led.
+ */
+class StimulusEncoder final {
+public:
+    // what the stand-in answers SystemGetHardwareState before the first hardware command
+    static constexpr const char *INITIAL_STATE = "MANUEL";
+
+    /**
+     * @throws std::runtime_error on an unknown state
+     */
+    Stimulus hardware(std::chrono::microseconds time, const std::string &state);
+
+    /**
+     * Empty: unset, left alone by the daemon.
+     */
+    Stimulus ambience(std::chrono::microseconds time, std::optional<bool> curtainUp, std::optional<bool> lightOn);
+    Stimulus timer(std::chrono::microseconds time, const std::string &modelTime, int multiplicator);
+    Stimulus error(std::chrono::microseconds time, const std::string &errorId, const std::string &text);
+    Stimulus disconnect(std::chrono::microseconds time);
+
+    /**
+     * The answer to SystemGetHardwareState.
+     */
+    static StandinServer::Frame hardwareStateFrame(const char *state);
+
+    /**
+     * ClientConnected, the answer to ClientStart.
+     */
+    static StandinServer::Frame connectedFrame(int appId);
+
+private:
+    const char *state{INITIAL_STATE};
+    // unknown until the first light command
+    std::optional<bool> light;
+    // AUTOMATIC started an eclipse, MANUEL stops it
+    bool eclipsed{false};
+    // when the eclipse started, the daemon restores it when it stops
+    std::optional<bool> lightBeforeEclipse;
+};
+
+/**
+ * The commands of a script (see sim/script.h for the syntax):
+ *   hardware ERROR|STANDBY|EMERGENCY_STOP|MANUEL|AUTOMATIC
+ *   ambience [curtain=on|off] [light=on|off]
+ *   timer <hh:mm> [<multiplicator>]
+ *   error <id> [text...]
+ *   disconnect               drops the connection, the daemon reconnects
+ *
+ * @param speed > 1 plays the script faster
+ * @throws std::runtime_error on an invalid command, with its line
+ */
+std::vector<Stimulus> scriptedStream(const std::vector<ScriptEvent> &events, double speed);
+
+/**
+ * Poisson arrivals at rate messages/s: 60% ambience, 15% hardware state,
+ * 15% timer, 10% client error. Reproducible for the same seed.
+ * @param dropEvery a disconnect every dropEvery, zero for none
+ */
+std::vector<Stimulus> randomStream(
+    double rate, std::chrono::milliseconds duration, std::uint64_t seed, std::chrono::milliseconds dropEvery
+);
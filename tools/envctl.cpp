@@ -0,0 +1,128 @@
+/*
+ *  Project:    moba-environment
+ *
+ *  Copyright (C) 2026 Stefan Paproth <pappi-@gmx.de>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as
+ *  published by the Free Software Foundation, either version 3 of the
+ *  License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/agpl.txt>.
+ *
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <string>
+
+#include "localchannel.h"
+
+/*
+ * Sends a command to a moba-environment daemon running on the same host:
+ *
+ *   moba-environment-ctl ambience [curtain=on|off] [light=on|off]
+ *   moba-environment-ctl curtain up|down
+ *   moba-environment-ctl effect <name> [sync]
+ *   moba-environment-ctl scene <name>
+ *   moba-environment-ctl calibrate <seconds>
+ *
+ * Effects are sounds: rain, birds, wind (loops), thunder (one shot);
+ * <sound>.off stops a loop, quiet stops all loops. With sync the effect
+ * starts at the same moment on all nodes synchronised by section [sync].
+ * Scenes are defined in the daemon's config, section [scenes]. calibrate
+ * measures the contact bounce of the inputs, operate them meanwhile; the
+ * daemon stores the debounce windows.
+ *
+ * The channel name defaults to LocalChannel::DEFAULT_NAME and may be
+ * overridden with the environment variable MOBA_ENVIRONMENT_CHANNEL.
+ */
+
+namespace {
+    [[noreturn]] void usage(const char *name) {
+        std::fprintf(
+            stderr,
+            "usage: %s ambience [curtain=on|off] [light=on|off]\n"
+            "       %s curtain up|down\n"
+            "       %s effect rain|birds|wind|thunder|<loop>.off|quiet [sync]\n"
+            "       %s scene <name>\n"
+            "       %s calibrate <seconds>\n",
+            name, name, name, name, name
+        );
+        std::exit(EXIT_FAILURE);
+    }
+
+    LocalCommand::Toggle toToggle(const std::string &val, const char *name) {
+        if(val == "on") {
+            return LocalCommand::Toggle::ON;
+        }
+        if(val == "off") {
+            return LocalCommand::Toggle::OFF;
+        }
+        usage(name);
+    }
+}
+
+int main(const int argc, char *argv[]) {
+    if(argc < 2) {
+        usage(argv[0]);
+    }
+
+    std::string cmdName{argv[1]};
+    LocalCommand cmd{};
+
+    if(cmdName == "ambience") {
+        cmd.type = LocalCommand::Type::AMBIENCE;
+        for(int i = 2; i < argc; ++i) {
+            std::string arg{argv[i]};
+            if(arg.starts_with("curtain=")) {
+                cmd.curtainUp = toToggle(arg.substr(8), argv[0]);
+            } else if(arg.starts_with("light=")) {
+                cmd.mainLightOn = toToggle(arg.substr(6), argv[0]);
+            } else {
+                usage(argv[0]);
+            }
+        }
+    } else if(cmdName == "curtain" && argc == 3 && std::strcmp(argv[2], "up") == 0) {
+        cmd.type = LocalCommand::Type::CURTAIN_UP;
+    } else if(cmdName == "curtain" && argc == 3 && std::strcmp(argv[2], "down") == 0) {
+        cmd.type = LocalCommand::Type::CURTAIN_DOWN;
+    } else if(
+        cmdName == "effect" && (argc == 3 || (argc == 4 && std::strcmp(argv[3], "sync") == 0)) &&
+        std::strlen(argv[2]) < LocalCommand::NAME_SIZE
+    ) {
+        cmd.type = LocalCommand::Type::EFFECT;
+        std::strncpy(cmd.name, argv[2], LocalCommand::NAME_SIZE - 1);
+        cmd.synced = argc == 4;
+    } else if(cmdName == "scene" && argc == 3 && std::strlen(argv[2]) < LocalCommand::NAME_SIZE) {
+        cmd.type = LocalCommand::Type::SCENE;
+        std::strncpy(cmd.name, argv[2], LocalCommand::NAME_SIZE - 1);
+    } else if(cmdName == "calibrate" && argc == 3 && std::atoi(argv[2]) > 0) {
+        cmd.type = LocalCommand::Type::CALIBRATE;
+        cmd.duration = static_cast<std::uint32_t>(std::atoi(argv[2]));
+    } else {
+        usage(argv[0]);
+    }
+
+    try {
+        auto channelName = std::getenv("MOBA_ENVIRONMENT_CHANNEL");
+        LocalChannel channel{channelName ? channelName : LocalChannel::DEFAULT_NAME, LocalChannel::Mode::CLIENT};
+
+        if(!channel.send(cmd)) {
+            std::fprintf(stderr, "local channel is full\n");
+            return EXIT_FAILURE;
+        }
+    } catch(const std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}